@@ -0,0 +1,18 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+
+void main()
+{
+    // the target is half the source, so each corner tap averages 2x2 source texels
+    vec2 halfTexel = 0.5 / textureSize(source, 0);
+    vec3 result = texture(source, TexCoords).rgb * 4.0;
+    result += texture(source, TexCoords + vec2(-halfTexel.x, -halfTexel.y)).rgb;
+    result += texture(source, TexCoords + vec2( halfTexel.x, -halfTexel.y)).rgb;
+    result += texture(source, TexCoords + vec2(-halfTexel.x,  halfTexel.y)).rgb;
+    result += texture(source, TexCoords + vec2( halfTexel.x,  halfTexel.y)).rgb;
+    FragColor = vec4(result / 8.0, 1.0);
+}
@@ -7,11 +7,45 @@ uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform bool bloom;
 uniform float exposure;
+// set when the scene was rendered below the framebuffer size
+uniform bool upscale;
+
+// Catmull-Rom over 4x4 texels in 9 bilinear taps; sharper than plain bilinear when upscaling.
+vec3 sampleCatmullRom(sampler2D image, vec2 uv)
+{
+    vec2 imageSize = vec2(textureSize(image, 0));
+    vec2 samplePos = uv * imageSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // the middle two texels are fetched with one bilinear tap
+    vec2 w12 = w1 + w2;
+    vec2 texPos0 = (texPos1 - 1.0) / imageSize;
+    vec2 texPos3 = (texPos1 + 2.0) / imageSize;
+    vec2 texPos12 = (texPos1 + w2 / w12) / imageSize;
+
+    vec3 result = texture(image, vec2(texPos0.x, texPos0.y)).rgb * w0.x * w0.y;
+    result += texture(image, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    result += texture(image, vec2(texPos3.x, texPos0.y)).rgb * w3.x * w0.y;
+    result += texture(image, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+    result += texture(image, vec2(texPos12.x, texPos12.y)).rgb * w12.x * w12.y;
+    result += texture(image, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+    result += texture(image, vec2(texPos0.x, texPos3.y)).rgb * w0.x * w3.y;
+    result += texture(image, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    result += texture(image, vec2(texPos3.x, texPos3.y)).rgb * w3.x * w3.y;
+    // the negative lobes can ring below zero next to bright HDR texels
+    return max(result, vec3(0.0));
+}
 
 void main()
 {             
     const float gamma = 1.6f;
-    vec3 hdrColor = texture(scene, TexCoords).rgb;      
+    vec3 hdrColor = upscale ? sampleCatmullRom(scene, TexCoords) : texture(scene, TexCoords).rgb;
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
     if(bloom)
         hdrColor += bloomColor; // additive blending
@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+
+void main()
+{
+    // tent over the coarser level: four edge taps and four diagonal ones weighted twice
+    vec2 halfTexel = 0.5 / textureSize(source, 0);
+    vec3 result = texture(source, TexCoords + vec2(-halfTexel.x * 2.0, 0.0)).rgb;
+    result += texture(source, TexCoords + vec2( halfTexel.x * 2.0, 0.0)).rgb;
+    result += texture(source, TexCoords + vec2(0.0, -halfTexel.y * 2.0)).rgb;
+    result += texture(source, TexCoords + vec2(0.0,  halfTexel.y * 2.0)).rgb;
+    result += texture(source, TexCoords + vec2(-halfTexel.x,  halfTexel.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2( halfTexel.x,  halfTexel.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(-halfTexel.x, -halfTexel.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2( halfTexel.x, -halfTexel.y)).rgb * 2.0;
+    FragColor = vec4(result / 12.0, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// HDR scene with the bloom threshold of each pixel in alpha
+uniform sampler2D scene;
+// scene texels per target texel along each side
+uniform float downscale;
+// global threshold for scene formats without alpha; negative reads it from the alpha
+uniform float threshold;
+
+vec3 brightPart(vec2 uv)
+{
+    vec4 color = texture(scene, uv);
+    float brightness = dot(color.rgb, vec3(0.2126, 0.7152, 0.0722));
+    return brightness > (threshold < 0.0 ? color.a : threshold) ? color.rgb : vec3(0.0);
+}
+
+void main()
+{
+    // four taps a quarter of a target texel off its centre, each thresholded on its own so
+    // a bright texel is not lost by averaging it with dark neighbours first; at half size
+    // they land on the four scene texels, at quarter size each filters a 2x2 block
+    vec2 offset = 0.25 * downscale / vec2(textureSize(scene, 0));
+    vec3 result = brightPart(TexCoords + vec2(-offset.x, -offset.y));
+    result += brightPart(TexCoords + vec2( offset.x, -offset.y));
+    result += brightPart(TexCoords + vec2(-offset.x,  offset.y));
+    result += brightPart(TexCoords + vec2( offset.x,  offset.y));
+    FragColor = vec4(result * 0.25, 1.0);
+}
@@ -1,31 +1,46 @@
  #version 430 core
+// alpha carries the bloom threshold to the bright pass
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 float AMBIENT = 0.08;
 float PI = 3.14;
 
-uniform sampler2D albedoTexture;
-uniform sampler2D normalTexture;
-uniform sampler2D aoTexture;
-uniform sampler2D roughnessTexture;
-uniform sampler2D metallicTexture;
-
-uniform vec3 cameraPos;
-
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-// Add uniform variables for cone light
-uniform vec3 spotlightPos;
-uniform vec3 spotlightConeDir;
-uniform vec3 spotlightColor;
-uniform float spotlightPhi;
-
-uniform float exposition;
+uniform sampler2DArray materialMaps;
+
+// array layer of each map and the bloom threshold, see Core::MaterialData
+struct Material
+{
+	int albedo;
+	int normal;
+	int ao;
+	int roughness;
+	int metallic;
+	float bloomThreshold;
+};
+
+layout(std430, binding = 1) readonly buffer MaterialTable
+{
+	Material materials[];
+};
+
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 viewProjection;
+	mat4 skyboxViewProjection;
+	vec3 cameraPos;
+	float exposition;
+	vec3 lightPos;
+	float spotlightPhi;
+	vec3 lightColor;
+	vec3 spotlightPos;
+	vec3 spotlightConeDir;
+	vec3 spotlightColor;
+};
 
 in vec3 vecNormal;
 in vec3 worldPos;
 in vec2 vecTex;
+flat in int vecMaterial;
 
 in vec3 viewDirTS;
 in vec3 lightDirTS;
@@ -34,6 +49,14 @@ in vec3 sunDirTS;
 
 in vec3 test;
 
+vec3 albedo;
+float roughness;
+float metallic;
+
+vec4 sampleMap(int layer){
+    return texture(materialMaps, vec3(vecTex, layer));
+}
+
 float DistributionGGX(vec3 normal, vec3 H, float roughness){
     float a      = roughness * roughness;
     float a2     = a * a;
@@ -74,18 +97,18 @@ vec3 PBRLight(vec3 lightDir, vec3 radiance, vec3 normal, vec3 V){
     float diffuse = max(0, dot(normal, lightDir));
 
     vec3 F0 = vec3(0.04);
-    F0 = mix(F0, texture(albedoTexture, vecTex).rgb, texture(metallicTexture, vecTex).r);
+    F0 = mix(F0, albedo, metallic);
 
     vec3 H = normalize(V + lightDir);
 
     // Cook-Torrance BRDF
-    float NDF = DistributionGGX(normal, H, texture(roughnessTexture, vecTex).r);
-    float G   = GeometrySmith(normal, V, lightDir, texture(roughnessTexture, vecTex).r);
+    float NDF = DistributionGGX(normal, H, roughness);
+    float G   = GeometrySmith(normal, V, lightDir, roughness);
     vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
 
     vec3 kS = F;
     vec3 kD = vec3(1.0) - kS;
-    kD *= 1.0 - texture(metallicTexture, vecTex).r;
+    kD *= 1.0 - metallic;
 
     vec3 numerator    = NDF * G * F;
     float denominator = 4.0 * max(dot(normal, V), 0.0) * max(dot(normal, lightDir), 0.0) + 0.0001;
@@ -93,17 +116,22 @@ vec3 PBRLight(vec3 lightDir, vec3 radiance, vec3 normal, vec3 V){
 
     // Add to outgoing radiance Lo
     float NdotL = max(dot(normal, lightDir), 0.0);
-    return (kD * texture(albedoTexture, vecTex).rgb / PI + specular) * radiance * NdotL;
+    return (kD * albedo / PI + specular) * radiance * NdotL;
 }
 
 void main(){
-    vec3 normal = normalize(texture(normalTexture, vecTex).xyz * 2.0 - 1.0);
+    Material material = materials[vecMaterial];
+    albedo = sampleMap(material.albedo).rgb;
+    roughness = sampleMap(material.roughness).r;
+    metallic = sampleMap(material.metallic).r;
+
+    vec3 normal = normalize(sampleMap(material.normal).xyz * 2.0 - 1.0);
 
     vec3 lightDir = normalize(lightDirTS);
     vec3 viewDir = normalize(viewDirTS);
 
-    vec3 ambient = AMBIENT * texture(albedoTexture, vecTex).rgb * texture(aoTexture, vecTex).r;
-    //vec3 ambient = AMBIENT * texture(albedoTexture, vecTex).rgb;
+    vec3 ambient = AMBIENT * albedo * sampleMap(material.ao).r;
+    //vec3 ambient = AMBIENT * albedo;
     vec3 attenuatedlightColor = lightColor / pow(length(lightPos - worldPos), 2);
     vec3 ilumination;
     ilumination = ambient + PBRLight(lightDir, attenuatedlightColor, normal, viewDir);
@@ -121,11 +149,5 @@ void main(){
     attenuatedlightColor *= 900.0;
 	ilumination=ilumination+PBRLight(spotlightDir,attenuatedlightColor,normal,viewDir);
 
-    FragColor = vec4(vec3(1.0) - exp(-ilumination * exposition), 1);
-
-    float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 0.9f)
-        BrightColor = vec4(FragColor.rgb, 1.0);
-	else
-		BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    FragColor = vec4(vec3(1.0) - exp(-ilumination * exposition), material.bloomThreshold);
 }
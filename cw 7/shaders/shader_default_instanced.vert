@@ -0,0 +1,53 @@
+#version 430 core
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec2 vertexTexCoord;
+layout(location = 3) in vec3 vertexTangent;
+layout(location = 4) in vec3 vertexBitangent;
+layout(location = 5) in mat4 instanceModelMatrix;
+layout(location = 9) in uint instanceMaterial;
+
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 viewProjection;
+	mat4 skyboxViewProjection;
+	vec3 cameraPos;
+	float exposition;
+	vec3 lightPos;
+	float spotlightPhi;
+	vec3 lightColor;
+	vec3 spotlightPos;
+	vec3 spotlightConeDir;
+	vec3 spotlightColor;
+};
+
+out vec3 vecNormal;
+out vec3 worldPos;
+
+out vec3 viewDirTS;
+out vec3 lightDirTS;
+out vec3 spotlightDirTS;
+out vec2 vecTex;
+flat out int vecMaterial;
+
+void main()
+{
+	worldPos = (instanceModelMatrix* vec4(vertexPosition,1)).xyz;
+	vecNormal = normalize((instanceModelMatrix* vec4(vertexNormal,0)).xyz);
+	gl_Position = viewProjection * vec4(worldPos, 1.0);
+	vec3 w_tangent = normalize(mat3(instanceModelMatrix)*vertexTangent);
+	vec3 w_bitangent = normalize(mat3(instanceModelMatrix)*vertexBitangent);
+	mat3 TBN = transpose(mat3(w_tangent, w_bitangent, vecNormal));
+	
+	vec3 V = normalize(cameraPos-worldPos);
+	viewDirTS = TBN*V;
+	vec3 L = normalize(lightPos-worldPos);
+	lightDirTS = TBN*L;
+	vec3 SL = normalize(spotlightPos-worldPos);
+	spotlightDirTS = TBN*SL;
+
+	vecMaterial = int(instanceMaterial);
+	vecTex = vertexTexCoord;
+    vecTex.y = 1.0 - vecTex.y;
+}
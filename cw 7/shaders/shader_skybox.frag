@@ -1,18 +1,13 @@
 #version 430 core
+// alpha carries the bloom threshold to the bright pass
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 uniform samplerCube skybox;
+uniform float bloomThreshold;
 
 in vec3 texCoord;
 
 void main()
 {
-	FragColor = texture(skybox,texCoord);
-
-    float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 0.6f)
-        BrightColor = vec4(FragColor.rgb, 1.0);
-	else
-		BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+	FragColor = vec4(texture(skybox,texCoord).rgb, bloomThreshold);
 }
\ No newline at end of file
@@ -2,12 +2,24 @@
 
 layout(location = 0) in vec3 vertexPosition;
 
-uniform mat4 transformation;
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 viewProjection;
+	mat4 skyboxViewProjection;
+	vec3 cameraPos;
+	float exposition;
+	vec3 lightPos;
+	float spotlightPhi;
+	vec3 lightColor;
+	vec3 spotlightPos;
+	vec3 spotlightConeDir;
+	vec3 spotlightColor;
+};
 
 out vec3 texCoord;
 
 void main()
 {
 	texCoord = vertexPosition;
-	gl_Position = transformation * vec4(vertexPosition, 1.0);
+	gl_Position = skyboxViewProjection * vec4(vertexPosition, 1.0);
 }
\ No newline at end of file
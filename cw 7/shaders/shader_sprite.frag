@@ -1,10 +1,11 @@
 #version 330 core
+// alpha carries the bloom threshold to the bright pass
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 in vec2 TexCoords;
 
 uniform sampler2D spriteTexture;
+uniform float bloomThreshold;
 
 void main()
 {    
@@ -13,11 +14,5 @@ void main()
     if (texColor.a < 0.1)
         discard;
     
-    FragColor = texColor*0.7;
-
-    float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 0.6f)
-        BrightColor = vec4(FragColor.rgb, 1.0);
-	else
-		BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    FragColor = vec4(texColor.rgb * 0.7, bloomThreshold);
 }
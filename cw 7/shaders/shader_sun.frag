@@ -1,14 +1,30 @@
 #version 430 core
 
+// alpha carries the bloom threshold to the bright pass
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 float AMBIENT = 0.3;
 float DIFFUSE_INTENSITY = 0.2;
 
 uniform vec3 lightDir;
-uniform sampler2D sunAlbedo;
-uniform sampler2D sunNormal;
+uniform sampler2DArray materialMaps;
+uniform int materialIndex;
+
+// array layer of each map and the bloom threshold, see Core::MaterialData
+struct Material
+{
+	int albedo;
+	int normal;
+	int ao;
+	int roughness;
+	int metallic;
+	float bloomThreshold;
+};
+
+layout(std430, binding = 1) readonly buffer MaterialTable
+{
+	Material materials[];
+};
 
 in vec3 vecNormal;
 in vec3 fragPos;
@@ -17,20 +33,15 @@ in vec2 vecTex;
 void main()
 {
     vec3 normal = normalize(vecNormal);
+    Material material = materials[materialIndex];
 
-    vec3 normalFromMap = normalize(texture2D(sunNormal, vecTex).xyz * 2.0 - 1.0);
+    vec3 normalFromMap = normalize(texture(materialMaps, vec3(vecTex, material.normal)).xyz * 2.0 - 1.0);
 
     float diffuse = max(0, dot(normalFromMap, lightDir));
     diffuse = pow(diffuse, DIFFUSE_INTENSITY); // Apply intensity control
 
-    vec4 albedoColor = texture2D(sunAlbedo, vecTex);
+    vec4 albedoColor = texture(materialMaps, vec3(vecTex, material.albedo));
     vec3 finalColor = albedoColor.rgb * min(1,diffuse + AMBIENT);
 
-    FragColor = vec4(finalColor, 1.0);
-
-    float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 0.1f)
-        BrightColor = vec4(FragColor.rgb, 1.0);
-	else
-		BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    FragColor = vec4(finalColor, material.bloomThreshold);
 }
\ No newline at end of file
@@ -4,7 +4,20 @@ layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexNormal;
 layout(location = 2) in vec2 vertexTexCoord;
 
-uniform mat4 transformation;
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 viewProjection;
+	mat4 skyboxViewProjection;
+	vec3 cameraPos;
+	float exposition;
+	vec3 lightPos;
+	float spotlightPhi;
+	vec3 lightColor;
+	vec3 spotlightPos;
+	vec3 spotlightConeDir;
+	vec3 spotlightColor;
+};
+
 uniform mat4 modelMatrix;
 
 out vec2 vecTex;
@@ -16,5 +29,5 @@ void main()
     fragPos = (modelMatrix * vec4(vertexPosition, 1.0)).xyz;
     vecNormal = normalize((modelMatrix * vec4(vertexNormal, 0.0)).xyz);
     vecTex = vec2(vertexTexCoord.x, vertexTexCoord.y);
-    gl_Position = transformation * vec4(vertexPosition, 1.0);
+    gl_Position = viewProjection * vec4(fragPos, 1.0);
 }
@@ -0,0 +1,127 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+    // control points of the loop, sampled with a closed Catmull-Rom spline
+    const glm::vec3 PATH_POINTS[] = {
+        glm::vec3(40.f, -20.f, 0.f),
+        glm::vec3(70.f, 5.f, 60.f),
+        glm::vec3(0.f, 30.f, 100.f),
+        glm::vec3(-40.f, 45.f, 30.f),
+        glm::vec3(10.f, 42.f, 5.f),
+        glm::vec3(90.f, 40.f, 10.f),
+        glm::vec3(120.f, 10.f, -60.f),
+        glm::vec3(20.f, -10.f, -110.f),
+        glm::vec3(-80.f, -5.f, -60.f),
+        glm::vec3(-60.f, -25.f, 20.f),
+    };
+    const int PATH_POINT_COUNT = sizeof(PATH_POINTS) / sizeof(PATH_POINTS[0]);
+
+    glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+    {
+        float t2 = t * t, t3 = t2 * t;
+        return 0.5f * (2.f * p1 + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+    }
+
+    float Percentile(std::vector<float> values, float fraction)
+    {
+        if (values.empty())
+            return 0.f;
+        size_t rank = std::min(values.size() - 1, (size_t)(values.size() * fraction));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+    void PrintDistribution(const char* name, const std::vector<float>& seconds)
+    {
+        if (seconds.empty())
+        {
+            std::cout << "  " << name << ": no samples" << std::endl;
+            return;
+        }
+        double total = 0.0;
+        for (float value : seconds) total += value;
+        std::cout << "  " << name << " ms: avg " << total / seconds.size() * 1000.0
+            << ", p50 " << Percentile(seconds, 0.5f) * 1000.f << ", p90 " << Percentile(seconds, 0.9f) * 1000.f
+            << ", p99 " << Percentile(seconds, 0.99f) * 1000.f << ", max " << *std::max_element(seconds.begin(), seconds.end()) * 1000.f
+            << " (" << seconds.size() << " frames)" << std::endl;
+    }
+}
+
+bool Core::ParseResolution(const std::string& text, int& width, int& height)
+{
+    int w, h;
+    char separator;
+    if (std::sscanf(text.c_str(), "%d%c%d", &w, &separator, &h) != 3 || separator != 'x' || w <= 0 || h <= 0)
+        return false;
+    width = w;
+    height = h;
+    return true;
+}
+
+void Core::SampleBenchmarkPath(float time, glm::vec3& position, glm::vec3& direction)
+{
+    float lap = std::fmod(time, BENCHMARK_PATH_DURATION) / BENCHMARK_PATH_DURATION * PATH_POINT_COUNT;
+    int segment = (int)lap;
+    float t = lap - segment;
+    auto point = [](int i) { return PATH_POINTS[(i % PATH_POINT_COUNT + PATH_POINT_COUNT) % PATH_POINT_COUNT]; };
+
+    position = CatmullRom(point(segment - 1), point(segment), point(segment + 1), point(segment + 2), t);
+    // heading from a point slightly ahead, which avoids differentiating the spline
+    float ahead = std::min(t + 0.05f, 1.f);
+    glm::vec3 next = ahead < 1.f
+        ? CatmullRom(point(segment - 1), point(segment), point(segment + 1), point(segment + 2), ahead)
+        : CatmullRom(point(segment), point(segment + 1), point(segment + 2), point(segment + 3), 0.05f);
+    direction = glm::normalize(next - position);
+}
+
+void Core::MeasureJobScaling(const char* name, int maxThreads, int repeats, const std::function<void(JobSystem&)>& work)
+{
+    std::cout << "job scaling, " << name << ":" << std::endl;
+    double singleThread = 0.0;
+    for (int threads = 1; threads <= std::max(1, maxThreads); threads++)
+    {
+        JobSystem jobs;
+        jobs.Init(threads - 1);
+        work(jobs);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+            work(jobs);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / std::max(1, repeats);
+        if (threads == 1)
+            singleThread = seconds;
+        std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ") << seconds * 1000.0 << " ms, "
+            << singleThread / seconds << "x" << std::endl;
+    }
+}
+
+void Core::BenchmarkRecorder::AddCpuFrame(float seconds, int drawCalls, int triangles, int passes)
+{
+    this->cpuFrameTimes.push_back(seconds);
+    this->drawCalls += drawCalls;
+    this->triangles += triangles;
+    this->passes += passes;
+}
+
+void Core::BenchmarkRecorder::AddGpuFrame(float seconds)
+{
+    this->gpuFrameTimes.push_back(seconds);
+}
+
+void Core::BenchmarkRecorder::Report(const BenchmarkSettings& settings) const
+{
+    size_t frames = std::max<size_t>(1, this->cpuFrameTimes.size());
+    std::cout << "benchmark: " << settings.width << "x" << settings.height << ", " << this->cpuFrameTimes.size() << " frames after "
+        << settings.warmupFrames << " warm-up frames, " << settings.frameTime * 1000.f << " ms simulated per frame" << std::endl;
+    PrintDistribution("cpu frame", this->cpuFrameTimes);
+    PrintDistribution("gpu frame", this->gpuFrameTimes);
+    std::cout << "  per frame: " << this->drawCalls / frames << " scene draw calls, " << this->triangles / frames << " triangles, "
+        << this->passes / frames << " render graph passes" << std::endl;
+}
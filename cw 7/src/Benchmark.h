@@ -0,0 +1,53 @@
+#pragma once
+
+#include "glm.hpp"
+#include "Job_System.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+	// Settings of a --benchmark run.
+	struct BenchmarkSettings
+	{
+		bool enabled = false;
+		int width = 1280;
+		int height = 720;
+		// measured frames, after the warm-up
+		int frames = 600;
+		// frames rendered first and not measured: shader compilation, target pool allocation
+		int warmupFrames = 30;
+		// simulated time between frames, so every run animates the same scene
+		float frameTime = 1.f / 60.f;
+	};
+
+	// Parses "1280x720"; returns false for anything else.
+	bool ParseResolution(const std::string& text, int& width, int& height);
+
+	// Scripted flight for benchmarks: a closed loop past the inner planets, through the
+	// asteroid field and around the sun, one lap every BENCHMARK_PATH_DURATION seconds.
+	const float BENCHMARK_PATH_DURATION = 40.f;
+	void SampleBenchmarkPath(float time, glm::vec3& position, glm::vec3& direction);
+
+	// Runs the work on job systems of 1 up to maxThreads threads, a warm-up and then repeats
+	// times each, and prints the average time and the speedup over one thread.
+	void MeasureJobScaling(const char* name, int maxThreads, int repeats, const std::function<void(JobSystem&)>& work);
+
+	// Collects per-frame numbers of a benchmark run and prints their distribution.
+	class BenchmarkRecorder
+	{
+	public:
+		void AddCpuFrame(float seconds, int drawCalls, int triangles, int passes);
+		// GPU times come in a few frames late, as the timer queries finish.
+		void AddGpuFrame(float seconds);
+		void Report(const BenchmarkSettings& settings) const;
+
+	private:
+		std::vector<float> cpuFrameTimes;
+		std::vector<float> gpuFrameTimes;
+		double drawCalls = 0.0;
+		double triangles = 0.0;
+		double passes = 0.0;
+	};
+}
@@ -0,0 +1,100 @@
+#include "Bloom_Pyramid.h"
+#include "Render_State.h"
+#include "Render_Utils.h"
+#include "Texture.h"
+
+#include <string>
+
+namespace
+{
+    // levels stop early once a side would drop below one texel
+    int LevelSizes(int width, int height, int levelWidths[Core::BLOOM_PYRAMID_LEVELS], int levelHeights[Core::BLOOM_PYRAMID_LEVELS])
+    {
+        int levelCount = 0;
+        for (int level = 0; level < Core::BLOOM_PYRAMID_LEVELS; level++)
+        {
+            levelWidths[level] = width >> (level + 1);
+            levelHeights[level] = height >> (level + 1);
+            if (levelWidths[level] < 1 || levelHeights[level] < 1)
+                break;
+            levelCount++;
+        }
+        return levelCount;
+    }
+}
+
+Core::BloomPyramid::BloomPyramid() : downsampleProgram(0), upsampleProgram(0) {}
+
+void Core::BloomPyramid::Init(const Shader_Loader& loader, GLuint downsampleProgram, GLuint upsampleProgram)
+{
+    this->downsampleProgram = downsampleProgram;
+    this->upsampleProgram = upsampleProgram;
+    this->downsampleSource = loader.GetSampler(downsampleProgram, "source");
+    this->upsampleSource = loader.GetSampler(upsampleProgram, "source");
+}
+
+Core::GraphResource Core::BloomPyramid::AddPasses(RenderGraph& graph, GraphResource bright) const
+{
+    const GraphTextureDesc& brightDesc = graph.GetDesc(bright);
+    int levelWidths[BLOOM_PYRAMID_LEVELS], levelHeights[BLOOM_PYRAMID_LEVELS];
+    int levelCount = LevelSizes(brightDesc.width, brightDesc.height, levelWidths, levelHeights);
+    if (levelCount == 0)
+        return bright;
+
+    GLuint downsampleProgram = this->downsampleProgram;
+    GLuint upsampleProgram = this->upsampleProgram;
+    Sampler downsampleSource = this->downsampleSource;
+    Sampler upsampleSource = this->upsampleSource;
+
+    GraphResource levels[BLOOM_PYRAMID_LEVELS];
+    for (int level = 0; level < levelCount; level++)
+    {
+        RenderPassBuilder pass = graph.AddPass("bloom downsample " + std::to_string(level));
+        GraphResource source = pass.Read(level == 0 ? bright : levels[level - 1]);
+        levels[level] = pass.Create("bloom level " + std::to_string(level), { levelWidths[level], levelHeights[level], brightDesc.format });
+        pass.Execute([=](const RenderGraph& graph) {
+            Core::UseProgram(downsampleProgram);
+            Core::SetActiveTexture(graph.GetTexture(source), downsampleSource);
+            Core::DrawScreenQuad();
+        });
+    }
+
+    // each level becomes a mix of itself and the blurred level below it
+    for (int level = levelCount - 2; level >= 0; level--)
+    {
+        RenderPassBuilder pass = graph.AddPass("bloom upsample " + std::to_string(level));
+        GraphResource source = pass.Read(levels[level + 1]);
+        pass.Write(levels[level]);
+        pass.Execute([=](const RenderGraph& graph) {
+            Core::UseProgram(upsampleProgram);
+            Core::Enable(GL_BLEND);
+            glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+            glBlendColor(0.f, 0.f, 0.f, BLOOM_UPSAMPLE_MIX);
+            Core::SetActiveTexture(graph.GetTexture(source), upsampleSource);
+            Core::DrawScreenQuad();
+            Core::Disable(GL_BLEND);
+        });
+    }
+    return levels[0];
+}
+
+std::vector<Core::BloomPassCost> Core::BloomPyramid::GetPassCosts(int width, int height, const TargetFormat& format) const
+{
+    int levelWidths[BLOOM_PYRAMID_LEVELS], levelHeights[BLOOM_PYRAMID_LEVELS];
+    int levelCount = LevelSizes(width, height, levelWidths, levelHeights);
+    const size_t texelBytes = format.bytesPerTexel;
+    std::vector<BloomPassCost> costs;
+    for (int level = 0; level < levelCount; level++)
+    {
+        size_t sourceTexels = level == 0 ? (size_t)width * height : (size_t)levelWidths[level - 1] * levelHeights[level - 1];
+        size_t targetTexels = (size_t)levelWidths[level] * levelHeights[level];
+        costs.push_back({ "downsample", levelWidths[level], levelHeights[level], 5, (sourceTexels + targetTexels) * texelBytes });
+    }
+    for (int level = levelCount - 2; level >= 0; level--)
+    {
+        size_t sourceTexels = (size_t)levelWidths[level + 1] * levelHeights[level + 1];
+        size_t targetTexels = (size_t)levelWidths[level] * levelHeights[level];
+        costs.push_back({ "upsample", levelWidths[level], levelHeights[level], 8, (sourceTexels + 2 * targetTexels) * texelBytes });
+    }
+    return costs;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "glew.h"
+#include "Render_Graph.h"
+#include "Render_Targets.h"
+#include "Shader_Loader.h"
+#include <vector>
+
+namespace Core
+{
+	// Levels below the bright buffer; level 0 is half its size, each next one half again.
+	// With the bright buffer at half the scene size the last level is 1/32 of the scene.
+	const int BLOOM_PYRAMID_LEVELS = 4;
+	// Weight of the coarser level when it is blended back up; higher spreads the glow further.
+	const float BLOOM_UPSAMPLE_MIX = 0.6f;
+
+	// Fill cost of one full-screen pass, for comparing bloom paths.
+	struct BloomPassCost
+	{
+		const char* name;
+		int width;
+		int height;
+		int taps;
+		// bytes of the source read once plus the target written (and read back when blended)
+		size_t bytes;
+	};
+
+	// Dual-filter bloom: the bright buffer is reduced through a chain of half-size levels
+	// with a 5-tap filter, then each level is upsampled with an 8-tap tent and blended into
+	// the one above. Every tap lands between texels, so bilinear filtering does half the work.
+	// The levels are transients of the render graph, in the format of the bright buffer.
+	class BloomPyramid
+	{
+	public:
+		BloomPyramid();
+		void Init(const Shader_Loader& loader, GLuint downsampleProgram, GLuint upsampleProgram);
+
+		// Declares the passes blurring the bright buffer and returns the level holding the
+		// result, half its size.
+		GraphResource AddPasses(RenderGraph& graph, GraphResource bright) const;
+
+		// One entry per pass of AddPasses for a bright buffer of this size and format, in order.
+		std::vector<BloomPassCost> GetPassCosts(int width, int height, const TargetFormat& format) const;
+
+	private:
+		GLuint downsampleProgram;
+		GLuint upsampleProgram;
+		Sampler downsampleSource;
+		Sampler upsampleSource;
+	};
+}
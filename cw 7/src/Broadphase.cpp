@@ -0,0 +1,187 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+Core::Broadphase::Broadphase(float cellSize, int bucketCount) : cellSize(cellSize), bucketCount(bucketCount), maxRadius(0.f), maxMotion(0.f)
+{
+    // the bucket is taken with a mask
+    while (this->bucketCount & (this->bucketCount - 1))
+        this->bucketCount++;
+    this->bucketStarts.assign(this->bucketCount + 1, 0);
+}
+
+void Core::Broadphase::Clear()
+{
+    this->proxies.clear();
+    this->proxyCells.clear();
+    this->proxyBuckets.clear();
+    this->largeProxies.clear();
+    this->bucketEntries.clear();
+    std::fill(this->bucketStarts.begin(), this->bucketStarts.end(), 0);
+    this->maxRadius = 0.f;
+    this->maxMotion = 0.f;
+}
+
+int Core::Broadphase::Add(const glm::vec3& center, float radius, uint32_t layers, int id, const glm::vec3& motion)
+{
+    this->proxies.push_back({ center, radius, layers, id, motion });
+    return (int)this->proxies.size() - 1;
+}
+
+glm::ivec3 Core::Broadphase::GetCell(const glm::vec3& position) const
+{
+    return glm::ivec3(glm::floor(position / this->cellSize));
+}
+
+int Core::Broadphase::GetBucket(const glm::ivec3& cell) const
+{
+    uint32_t hash = (uint32_t)cell.x * 73856093u ^ (uint32_t)cell.y * 19349663u ^ (uint32_t)cell.z * 83492791u;
+    return (int)(hash & (uint32_t)(this->bucketCount - 1));
+}
+
+void Core::Broadphase::Build()
+{
+    int count = (int)this->proxies.size();
+    this->proxyCells.resize(count);
+    this->proxyBuckets.assign(count, -1);
+    this->largeProxies.clear();
+    this->maxRadius = 0.f;
+    this->maxMotion = 0.f;
+    std::fill(this->bucketStarts.begin(), this->bucketStarts.end(), 0);
+
+    int gridded = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const BroadphaseProxy& proxy = this->proxies[i];
+        if (proxy.radius > this->cellSize * 0.5f)
+        {
+            this->largeProxies.push_back(i);
+            continue;
+        }
+        this->proxyCells[i] = this->GetCell(proxy.center);
+        this->proxyBuckets[i] = this->GetBucket(this->proxyCells[i]);
+        this->bucketStarts[this->proxyBuckets[i]]++;
+        this->maxRadius = std::max(this->maxRadius, proxy.radius);
+        this->maxMotion = std::max(this->maxMotion, glm::length(proxy.motion));
+        gridded++;
+    }
+    // every bucket's start moves to its end, then back down as the bucket is filled
+    for (int bucket = 1; bucket <= this->bucketCount; bucket++)
+        this->bucketStarts[bucket] += this->bucketStarts[bucket - 1];
+
+    // filled from the last proxy, so each bucket lists its proxies in the order they were added
+    this->bucketEntries.resize(gridded);
+    for (int i = count - 1; i >= 0; i--)
+    {
+        if (this->proxyBuckets[i] >= 0)
+            this->bucketEntries[--this->bucketStarts[this->proxyBuckets[i]]] = i;
+    }
+}
+
+bool Core::Broadphase::Overlaps(const BroadphaseProxy& proxy, const glm::vec3& center, float radius, uint32_t layers) const
+{
+    return (proxy.layers & layers) != 0 && glm::length(center - proxy.center) < radius + proxy.radius;
+}
+
+template <typename Visit>
+void Core::Broadphase::VisitCandidates(const glm::vec3& low, const glm::vec3& high, Visit visit) const
+{
+    for (int index : this->largeProxies)
+        visit(index);
+
+    // a proxy is filed where it ended the step, which is up to its radius and motion away
+    // from anything it covered
+    glm::vec3 reach(this->maxRadius + this->maxMotion);
+    glm::ivec3 first = this->GetCell(low - reach);
+    glm::ivec3 last = this->GetCell(high + reach);
+    glm::ivec3 size = last - first + 1;
+    // a query wider than the table would visit buckets more than once; scan instead
+    if ((int64_t)size.x * size.y * size.z > this->bucketCount)
+    {
+        for (int index : this->bucketEntries)
+            visit(index);
+        return;
+    }
+    for (int z = first.z; z <= last.z; z++)
+    {
+        for (int y = first.y; y <= last.y; y++)
+        {
+            for (int x = first.x; x <= last.x; x++)
+            {
+                glm::ivec3 cell(x, y, z);
+                int bucket = this->GetBucket(cell);
+                for (int entry = this->bucketStarts[bucket]; entry < this->bucketStarts[bucket + 1]; entry++)
+                {
+                    // other cells hashed into the same bucket are skipped, they are visited on their own
+                    int index = this->bucketEntries[entry];
+                    if (this->proxyCells[index] == cell)
+                        visit(index);
+                }
+            }
+        }
+    }
+}
+
+void Core::Broadphase::Query(const glm::vec3& center, float radius, uint32_t layers, std::vector<int>& results) const
+{
+    results.clear();
+    this->VisitCandidates(center - glm::vec3(radius), center + glm::vec3(radius), [&](int index) {
+        if (this->Overlaps(this->proxies[index], center, radius, layers))
+            results.push_back(index);
+    });
+    std::sort(results.begin(), results.end());
+}
+
+void Core::Broadphase::QuerySwept(const SweptSphere* spheres, int count, SweptHit* hits) const
+{
+    for (int i = 0; i < count; i++)
+    {
+        const SweptSphere& sphere = spheres[i];
+        SweptHit& hit = hits[i];
+        hit.proxy = -1;
+        hit.time = 1.f;
+        glm::vec3 low = glm::min(sphere.start, sphere.end) - glm::vec3(sphere.radius);
+        glm::vec3 high = glm::max(sphere.start, sphere.end) + glm::vec3(sphere.radius);
+        this->VisitCandidates(low, high, [&](int index) {
+            const BroadphaseProxy& proxy = this->proxies[index];
+            if ((proxy.layers & sphere.layers) == 0)
+                return;
+
+            // in the proxy's frame the sphere starts at offset and moves by velocity, and they
+            // touch while |offset + t * velocity| < radius
+            glm::vec3 offset = sphere.start - (proxy.center - proxy.motion);
+            glm::vec3 velocity = sphere.end - sphere.start - proxy.motion;
+            float radius = sphere.radius + proxy.radius;
+            float c = glm::dot(offset, offset) - radius * radius;
+            float time = 0.f;
+            if (c >= 0.f)
+            {
+                float a = glm::dot(velocity, velocity);
+                float b = glm::dot(offset, velocity);
+                float discriminant = b * b - a * c;
+                // apart at the start and not closing in, or passing wide
+                if (b >= 0.f || discriminant < 0.f)
+                    return;
+                time = (-b - std::sqrt(discriminant)) / a;
+                if (time > 1.f)
+                    return;
+            }
+            if (hit.proxy < 0 || time < hit.time || (time == hit.time && index < hit.proxy))
+            {
+                hit.proxy = index;
+                hit.time = time;
+            }
+        });
+    }
+}
+
+const Core::BroadphaseProxy& Core::Broadphase::GetProxy(int index) const
+{
+    return this->proxies[index];
+}
+
+int Core::Broadphase::GetProxyCount() const
+{
+    return (int)this->proxies.size();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "glm.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Core
+{
+	// Sphere the broadphase knows, with the layers it is on and an id that is the owner's.
+	// motion is how far it moved over the last step to reach center, taken as a straight line.
+	struct BroadphaseProxy
+	{
+		glm::vec3 center;
+		float radius;
+		uint32_t layers;
+		int id;
+		glm::vec3 motion;
+	};
+
+	// Sphere moving from start to end over the step, looking for proxies on its layers.
+	struct SweptSphere
+	{
+		glm::vec3 start;
+		glm::vec3 end;
+		float radius;
+		uint32_t layers;
+	};
+
+	// First proxy a swept sphere touches and when, 0 at the start of the step and 1 at its
+	// end; proxy is -1 when it touches none.
+	struct SweptHit
+	{
+		int proxy;
+		float time;
+	};
+
+	// Uniform grid of spheres, hashed into a fixed number of buckets so the world needs no
+	// bounds. Each sphere is filed under the cell of its center and a query widens by the
+	// largest radius filed, so a sphere is found once without being stored in several cells.
+	// Spheres wider than half a cell (the sun, the planets) are kept aside and always tested.
+	// Moving things are handled by refilling the grid: Clear, Add everything, Build, which is
+	// one counting sort and allocates nothing once the arrays have grown.
+	class Broadphase
+	{
+	public:
+		explicit Broadphase(float cellSize = 32.f, int bucketCount = 4096);
+
+		void Clear();
+		// Returns the proxy's index, which the results of Query refer to.
+		int Add(const glm::vec3& center, float radius, uint32_t layers, int id, const glm::vec3& motion = glm::vec3(0.f));
+		void Build();
+
+		// Fills results with the proxies on any of the layers whose sphere overlaps the given
+		// one, in the order they were added.
+		void Query(const glm::vec3& center, float radius, uint32_t layers, std::vector<int>& results) const;
+		// Finds the first hit of each swept sphere against the proxies moving along their
+		// motion at the same time, so a sphere fast enough to pass a proxy within one step
+		// still hits it. Ties go to the proxy added first.
+		void QuerySwept(const SweptSphere* spheres, int count, SweptHit* hits) const;
+		const BroadphaseProxy& GetProxy(int index) const;
+		int GetProxyCount() const;
+
+	private:
+		glm::ivec3 GetCell(const glm::vec3& position) const;
+		int GetBucket(const glm::ivec3& cell) const;
+		bool Overlaps(const BroadphaseProxy& proxy, const glm::vec3& center, float radius, uint32_t layers) const;
+		// Calls visit(index) once for every proxy that may have been between low and high
+		// during the step.
+		template <typename Visit>
+		void VisitCandidates(const glm::vec3& low, const glm::vec3& high, Visit visit) const;
+
+		float cellSize;
+		int bucketCount;
+		std::vector<BroadphaseProxy> proxies;
+		std::vector<glm::ivec3> proxyCells;
+		std::vector<int> largeProxies;
+		// proxies of bucket b are bucketEntries[bucketStarts[b]] up to bucketStarts[b + 1]
+		std::vector<int> bucketStarts;
+		std::vector<int> bucketEntries;
+		std::vector<int> proxyBuckets;
+		float maxRadius;
+		float maxMotion;
+	};
+}
@@ -0,0 +1,160 @@
+#include "Cpu_Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if CPU_PROFILER_ENABLED
+
+namespace
+{
+    // zones per thread between two flushes; a frame records a few dozen
+    const uint64_t RING_CAPACITY = 1 << 14;
+
+    struct ZoneEvent
+    {
+        const char* name;
+        int64_t begin;
+        int64_t end;
+    };
+
+    // Single producer (the owning thread), single consumer (the flush, under the registry lock).
+    struct ThreadRing
+    {
+        ZoneEvent events[RING_CAPACITY];
+        std::atomic<uint64_t> head{ 0 };
+        std::atomic<uint64_t> tail{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        int threadId = 0;
+    };
+
+    std::atomic<bool> capturing{ false };
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::ofstream traceFile;
+    bool firstEvent = true;
+    const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    thread_local ThreadRing* threadRing = nullptr;
+
+    int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    ThreadRing* GetThreadRing()
+    {
+        if (threadRing == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            rings.emplace_back(new ThreadRing());
+            threadRing = rings.back().get();
+            threadRing->threadId = (int)rings.size();
+        }
+        return threadRing;
+    }
+
+    void WriteEvents()
+    {
+        for (const std::unique_ptr<ThreadRing>& ring : rings)
+        {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            for (; tail < head; tail++)
+            {
+                const ZoneEvent& event = ring->events[tail % RING_CAPACITY];
+                traceFile << (firstEvent ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << ring->threadId << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+                firstEvent = false;
+            }
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+}
+
+bool Core::BeginTraceCapture(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (capturing.load())
+        return false;
+    traceFile.open(path);
+    if (!traceFile)
+    {
+        std::cerr << "cpu profiler: cannot write " << path << std::endl;
+        return false;
+    }
+    traceFile.precision(15);
+    traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    firstEvent = true;
+    capturing.store(true);
+    std::cout << "cpu profiler: capturing to " << path << std::endl;
+    return true;
+}
+
+void Core::FlushTraceCapture()
+{
+    if (!capturing.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    WriteEvents();
+}
+
+void Core::EndTraceCapture()
+{
+    if (!capturing.exchange(false))
+        return;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    WriteEvents();
+    traceFile << "\n]}\n";
+    traceFile.close();
+
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<ThreadRing>& ring : rings)
+        dropped += ring->dropped.load();
+    if (dropped > 0)
+        std::cout << "cpu profiler: " << dropped << " zones dropped on full rings" << std::endl;
+}
+
+bool Core::IsTraceCapturing()
+{
+    return capturing.load(std::memory_order_relaxed);
+}
+
+Core::ProfileZone::ProfileZone(const char* name) : name(name), begin(-1)
+{
+    if (capturing.load(std::memory_order_relaxed))
+        this->begin = Now();
+}
+
+Core::ProfileZone::~ProfileZone()
+{
+    if (this->begin < 0)
+        return;
+    int64_t end = Now();
+    ThreadRing* ring = GetThreadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->events[head % RING_CAPACITY] = { this->name, this->begin, end };
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+#else
+
+bool Core::BeginTraceCapture(const std::string& path)
+{
+    std::cout << "cpu profiler: compiled out, " << path << " not written" << std::endl;
+    return false;
+}
+
+void Core::FlushTraceCapture() {}
+void Core::EndTraceCapture() {}
+bool Core::IsTraceCapturing() { return false; }
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Build with CPU_PROFILER_ENABLED=0 to compile every zone out.
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 1
+#endif
+
+namespace Core
+{
+	// Starts recording zones into a Chrome Trace Event JSON file (chrome://tracing, Perfetto).
+	bool BeginTraceCapture(const std::string& path);
+	// Moves the zones every thread recorded so far into the file; called once per frame.
+	void FlushTraceCapture();
+	void EndTraceCapture();
+	bool IsTraceCapturing();
+
+	// Times its scope. Outside a capture it costs one relaxed atomic load; during one, two
+	// clock reads and a store into the ring buffer of the calling thread, which only the
+	// flush reads, so recording never takes a lock. Zones are dropped while a ring is full.
+	class ProfileZone
+	{
+	public:
+		// name must outlive the capture, a string literal or __FUNCTION__
+		explicit ProfileZone(const char* name);
+		~ProfileZone();
+
+	private:
+		const char* name;
+		int64_t begin;
+	};
+}
+
+#if CPU_PROFILER_ENABLED
+#define PROFILE_ZONE_CONCAT_(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) Core::ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
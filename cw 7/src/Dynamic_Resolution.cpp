@@ -0,0 +1,67 @@
+#include "Dynamic_Resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // weight of the newest frame in the moving average
+    const float FRAME_TIME_SMOOTHING = 0.1f;
+    // frames between two changes of the scale
+    const int SCALE_COOLDOWN = 30;
+    // band around the budget where the scale is left alone
+    const float OVER_BUDGET = 1.05f;
+    const float UNDER_BUDGET = 0.85f;
+}
+
+Core::DynamicResolution::DynamicResolution(float targetFrameTime)
+    : targetFrameTime(targetFrameTime), averageFrameTime(targetFrameTime), scale(RENDER_SCALE_MAX), cooldown(SCALE_COOLDOWN), enabled(true)
+{
+}
+
+bool Core::DynamicResolution::Update(float frameTime)
+{
+    this->averageFrameTime += (frameTime - this->averageFrameTime) * FRAME_TIME_SMOOTHING;
+    this->cooldown--;
+    if (!this->enabled || this->cooldown > 0)
+        return false;
+
+    float newScale = this->scale;
+    if (this->averageFrameTime > this->targetFrameTime * OVER_BUDGET)
+    {
+        // fill cost goes with the pixel count, so the side scales with the square root;
+        // large overruns drop several steps at once
+        float wanted = this->scale * std::sqrt(this->targetFrameTime / this->averageFrameTime);
+        newScale = std::min(this->scale - RENDER_SCALE_STEP, std::floor(wanted / RENDER_SCALE_STEP) * RENDER_SCALE_STEP);
+    }
+    else if (this->averageFrameTime < this->targetFrameTime * UNDER_BUDGET)
+        newScale = this->scale + RENDER_SCALE_STEP;
+
+    newScale = std::max(RENDER_SCALE_MIN, std::min(RENDER_SCALE_MAX, newScale));
+    if (std::fabs(newScale - this->scale) < RENDER_SCALE_STEP * 0.5f)
+        return false;
+
+    this->scale = newScale;
+    this->cooldown = SCALE_COOLDOWN;
+    return true;
+}
+
+void Core::DynamicResolution::SetEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+bool Core::DynamicResolution::IsEnabled() const
+{
+    return this->enabled;
+}
+
+float Core::DynamicResolution::GetScale() const
+{
+    return this->scale;
+}
+
+float Core::DynamicResolution::GetAverageFrameTime() const
+{
+    return this->averageFrameTime;
+}
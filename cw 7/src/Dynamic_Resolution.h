@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Core
+{
+	// Render scale range and the step it moves in; the scale multiplies both sides of the framebuffer.
+	const float RENDER_SCALE_MIN = 0.5f;
+	const float RENDER_SCALE_MAX = 1.f;
+	const float RENDER_SCALE_STEP = 0.05f;
+
+	// Frame-time controller for the render scale. It lowers the scale while frames run over
+	// the budget and raises it again once they are clearly under, at most once per cooldown,
+	// so targets are not reallocated every frame. Fed with GPU time, it is not fooled by vsync.
+	class DynamicResolution
+	{
+	public:
+		explicit DynamicResolution(float targetFrameTime = 1.f / 60.f);
+
+		// Feeds the time of one frame in seconds; returns true when the scale changed.
+		bool Update(float frameTime);
+
+		void SetEnabled(bool enabled);
+		bool IsEnabled() const;
+		float GetScale() const;
+		// Smoothed frame time the decisions are made on.
+		float GetAverageFrameTime() const;
+
+	private:
+		float targetFrameTime;
+		float averageFrameTime;
+		float scale;
+		int cooldown;
+		bool enabled;
+	};
+}
@@ -0,0 +1,83 @@
+#include "Entity_Store.h"
+
+Core::EntityHandle Core::EntityStore::Create(const glm::vec3& position, float radius, uint32_t flags)
+{
+    EntityHandle handle;
+    if (!this->freeSlots.empty())
+    {
+        handle.slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+    else
+    {
+        handle.slot = (uint32_t)this->slots.size();
+        this->slots.push_back({ -1, 0 });
+    }
+    Slot& slot = this->slots[handle.slot];
+    slot.index = this->GetCount();
+    handle.generation = slot.generation;
+
+    this->positions.push_back(position);
+    this->radii.push_back(radius);
+    this->flags.push_back(flags);
+    this->denseSlots.push_back(handle.slot);
+    return handle;
+}
+
+void Core::EntityStore::Destroy(EntityHandle handle)
+{
+    int index = this->GetIndex(handle);
+    if (index < 0)
+        return;
+
+    int last = this->GetCount() - 1;
+    this->positions[index] = this->positions[last];
+    this->radii[index] = this->radii[last];
+    this->flags[index] = this->flags[last];
+    this->denseSlots[index] = this->denseSlots[last];
+    this->slots[this->denseSlots[index]].index = index;
+    this->positions.pop_back();
+    this->radii.pop_back();
+    this->flags.pop_back();
+    this->denseSlots.pop_back();
+
+    Slot& slot = this->slots[handle.slot];
+    slot.index = -1;
+    slot.generation++;
+    this->freeSlots.push_back(handle.slot);
+}
+
+bool Core::EntityStore::IsAlive(EntityHandle handle) const
+{
+    return this->GetIndex(handle) >= 0;
+}
+
+int Core::EntityStore::GetIndex(EntityHandle handle) const
+{
+    if (handle.slot >= this->slots.size() || this->slots[handle.slot].generation != handle.generation)
+        return -1;
+    return this->slots[handle.slot].index;
+}
+
+Core::EntityHandle Core::EntityStore::GetHandle(int index) const
+{
+    EntityHandle handle;
+    handle.slot = this->denseSlots[index];
+    handle.generation = this->slots[handle.slot].generation;
+    return handle;
+}
+
+void Core::EntityStore::Clear()
+{
+    // live slots are retired, so handles from before the clear stop resolving
+    for (uint32_t slot : this->denseSlots)
+    {
+        this->slots[slot].index = -1;
+        this->slots[slot].generation++;
+        this->freeSlots.push_back(slot);
+    }
+    this->positions.clear();
+    this->radii.clear();
+    this->flags.clear();
+    this->denseSlots.clear();
+}
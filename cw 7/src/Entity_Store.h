@@ -0,0 +1,62 @@
+#pragma once
+
+#include "glm.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Core
+{
+	enum EntityFlag
+	{
+		// drawn and counted by the game
+		ENTITY_VISIBLE = 1 << 0,
+		// touched by a collision test since the flag was last cleared
+		ENTITY_HIT = 1 << 1
+	};
+
+	// Refers to an entity for as long as it lives; a destroyed entity's handle stops
+	// resolving even after its slot is reused.
+	struct EntityHandle
+	{
+		uint32_t slot = ~0u;
+		uint32_t generation = 0;
+	};
+
+	// Collision entities in dense arrays: position, radius and flags of entity i are at index
+	// i of each, with no gaps, so hot loops walk them linearly. Handles map to the dense index
+	// through a slot table in O(1); destroying an entity moves the last one into its place.
+	class EntityStore
+	{
+	public:
+		EntityHandle Create(const glm::vec3& position, float radius, uint32_t flags = 0);
+		void Destroy(EntityHandle handle);
+		bool IsAlive(EntityHandle handle) const;
+		// Dense index of a live entity, -1 for a dead handle.
+		int GetIndex(EntityHandle handle) const;
+		EntityHandle GetHandle(int index) const;
+		void Clear();
+
+		int GetCount() const { return (int)this->positions.size(); }
+		glm::vec3* GetPositions() { return this->positions.data(); }
+		const glm::vec3* GetPositions() const { return this->positions.data(); }
+		float* GetRadii() { return this->radii.data(); }
+		const float* GetRadii() const { return this->radii.data(); }
+		uint32_t* GetFlags() { return this->flags.data(); }
+		const uint32_t* GetFlags() const { return this->flags.data(); }
+
+	private:
+		std::vector<glm::vec3> positions;
+		std::vector<float> radii;
+		std::vector<uint32_t> flags;
+		// slot of each dense entity, for moving the last one on Destroy
+		std::vector<uint32_t> denseSlots;
+
+		struct Slot
+		{
+			int index;
+			uint32_t generation;
+		};
+		std::vector<Slot> slots;
+		std::vector<uint32_t> freeSlots;
+	};
+}
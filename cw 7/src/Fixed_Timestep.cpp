@@ -0,0 +1,36 @@
+#include "Fixed_Timestep.h"
+
+#include <algorithm>
+
+Core::FixedTimestep::FixedTimestep(float step, float maxCatchUp)
+    : step(step), maxCatchUp(maxCatchUp), accumulator(0.0), lastTime(0.0), started(false)
+{
+}
+
+int Core::FixedTimestep::Advance(double time)
+{
+    if (!this->started)
+    {
+        this->started = true;
+        this->lastTime = time;
+        return 0;
+    }
+
+    double frameTime = std::min(std::max(time - this->lastTime, 0.0), (double)this->maxCatchUp);
+    this->lastTime = time;
+    this->accumulator += frameTime;
+
+    int steps = (int)(this->accumulator / this->step);
+    this->accumulator -= steps * (double)this->step;
+    return steps;
+}
+
+float Core::FixedTimestep::GetStep() const
+{
+    return this->step;
+}
+
+float Core::FixedTimestep::GetAlpha() const
+{
+    return (float)(this->accumulator / this->step);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Core
+{
+	// Length of one simulation step: movement, the laser and collisions run at 120 Hz
+	// whatever the frame rate.
+	const float SIMULATION_STEP = 1.f / 120.f;
+	// Longest frame the simulation catches up on; a longer stall (loading, a debugger)
+	// slows the game down instead of running hundreds of steps in one frame.
+	const float MAX_SIMULATION_CATCH_UP = 0.25f;
+
+	// Accumulator of a fixed-step loop: turns frame times into a whole number of steps and
+	// the fraction of a step the frame is past the last one, to interpolate the render with.
+	class FixedTimestep
+	{
+	public:
+		explicit FixedTimestep(float step = SIMULATION_STEP, float maxCatchUp = MAX_SIMULATION_CATCH_UP);
+
+		// Takes the time of the new frame; returns how many steps to run. The first call
+		// only starts the clock.
+		int Advance(double time);
+
+		float GetStep() const;
+		// 0 right on the last step, approaching 1 just before the next one.
+		float GetAlpha() const;
+
+	private:
+		float step;
+		float maxCatchUp;
+		double accumulator;
+		double lastTime;
+		bool started;
+	};
+}
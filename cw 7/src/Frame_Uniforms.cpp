@@ -0,0 +1,24 @@
+#include "Frame_Uniforms.h"
+
+Core::FrameUniformBuffer::FrameUniformBuffer() : buffer(0) {}
+
+
+void Core::FrameUniformBuffer::Init() {
+    glGenBuffers(1, &this->buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, this->buffer);
+}
+
+void Core::FrameUniformBuffer::Destroy() {
+    glDeleteBuffers(1, &this->buffer);
+    this->buffer = 0;
+}
+
+void Core::FrameUniformBuffer::Update(const FrameUniforms& frame) {
+    glBindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+    // respecifying the store lets the driver orphan last frame's copy instead of stalling on it
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &frame, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
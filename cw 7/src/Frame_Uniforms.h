@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glew.h"
+#include "glm.hpp"
+
+namespace Core
+{
+	// Binding point of the PerFrame block in shader_default, shader_sun and shader_skybox.
+	const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+	// Mirrors the std140 PerFrame block: every vec3 shares its 16 bytes with the float after it.
+	struct FrameUniforms
+	{
+		glm::mat4 viewProjection;
+		glm::mat4 skyboxViewProjection;
+		glm::vec3 cameraPos;
+		float exposition;
+		glm::vec3 lightPos;
+		float spotlightPhi;
+		glm::vec3 lightColor;
+		float padding0;
+		glm::vec3 spotlightPos;
+		float padding1;
+		glm::vec3 spotlightConeDir;
+		float padding2;
+		glm::vec3 spotlightColor;
+		float padding3;
+	};
+
+	static_assert(sizeof(FrameUniforms) == 224, "FrameUniforms must match the std140 PerFrame block");
+
+	class FrameUniformBuffer
+	{
+	public:
+		FrameUniformBuffer();
+		void Init();
+		void Destroy();
+		// Uploads the whole block once per frame.
+		void Update(const FrameUniforms& frame);
+
+	private:
+		GLuint buffer;
+	};
+}
@@ -0,0 +1,88 @@
+#include "Frustum.h"
+
+#include <algorithm>
+
+Core::Frustum::Frustum()
+{
+    for (int i = 0; i < 6; i++)
+        planes[i] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
+Core::Frustum Core::ExtractFrustum(const glm::mat4& viewProjection)
+{
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::mat4 m = glm::transpose(viewProjection);
+
+    Frustum frustum;
+    frustum.planes[0] = m[3] + m[0];
+    frustum.planes[1] = m[3] - m[0];
+    frustum.planes[2] = m[3] + m[1];
+    frustum.planes[3] = m[3] - m[1];
+    frustum.planes[4] = m[3] + m[2];
+    frustum.planes[5] = m[3] - m[2];
+    for (int i = 0; i < 6; i++)
+        frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+    return frustum;
+}
+
+bool Core::IsSphereVisible(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(frustum.planes[i]), center) + frustum.planes[i].w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool Core::IsBoxVisible(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const glm::vec4& plane = frustum.planes[i];
+        // the corner furthest along the plane normal
+        glm::vec3 positive(plane.x >= 0.f ? boundsMax.x : boundsMin.x,
+            plane.y >= 0.f ? boundsMax.y : boundsMin.y,
+            plane.z >= 0.f ? boundsMax.z : boundsMin.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.f)
+            return false;
+    }
+    return true;
+}
+
+void Core::TransformBoundingSphere(const RenderContext& context, const glm::mat4& modelMatrix, glm::vec3& center, float& radius)
+{
+    center = glm::vec3(modelMatrix * glm::vec4(context.sphereCenter, 1.f));
+    float scale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+        std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    radius = context.sphereRadius * scale;
+}
+
+bool Core::IsVisible(const Frustum& frustum, const RenderContext& context, const glm::mat4& modelMatrix)
+{
+    glm::vec3 center;
+    float radius;
+    TransformBoundingSphere(context, modelMatrix, center, radius);
+
+    bool straddles = false;
+    for (int i = 0; i < 6; i++)
+    {
+        float distance = glm::dot(glm::vec3(frustum.planes[i]), center) + frustum.planes[i].w;
+        if (distance < -radius)
+            return false;
+        if (distance < radius)
+            straddles = true;
+    }
+    if (!straddles)
+        return true;
+
+    // world AABB of the transformed local box (Arvo)
+    glm::vec3 localCenter = (context.boundsMin + context.boundsMax) * 0.5f;
+    glm::vec3 localExtent = (context.boundsMax - context.boundsMin) * 0.5f;
+    glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(localCenter, 1.f));
+    glm::vec3 worldExtent(0.f);
+    for (int column = 0; column < 3; column++)
+        worldExtent += glm::abs(glm::vec3(modelMatrix[column])) * localExtent[column];
+
+    return IsBoxVisible(frustum, worldCenter - worldExtent, worldCenter + worldExtent);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "glm.hpp"
+#include "Render_Utils.h"
+
+namespace Core
+{
+	// Six planes of the camera frustum (left, right, bottom, top, near, far), normals pointing inwards.
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+
+		// Until a matrix is given the frustum accepts everything.
+		Frustum();
+	};
+
+	// What draw submission needs to know about the camera: the culling planes, and the position
+	// and vertical projection scale that LOD selection uses to estimate screen size.
+	struct CameraView
+	{
+		Frustum frustum;
+		glm::vec3 position = glm::vec3(0.f);
+		float projectionScale = 1.f;
+	};
+
+	// Gribb-Hartmann extraction from the view-projection built by createPerspectiveMatrix and createCameraMatrix.
+	Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+	bool IsSphereVisible(const Frustum& frustum, const glm::vec3& center, float radius);
+	bool IsBoxVisible(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+	// World-space bounding sphere of the context placed by the model matrix.
+	void TransformBoundingSphere(const RenderContext& context, const glm::mat4& modelMatrix, glm::vec3& center, float& radius);
+
+	// Tests the mesh bounds of the context placed by the model matrix. The sphere is checked first;
+	// the box only when the sphere straddles a plane.
+	bool IsVisible(const Frustum& frustum, const RenderContext& context, const glm::mat4& modelMatrix);
+}
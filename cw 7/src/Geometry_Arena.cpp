@@ -0,0 +1,160 @@
+#include "Geometry_Arena.h"
+#include "Mesh_Simplifier.h"
+#include "Render_State.h"
+
+#include <cstddef>
+#include <iostream>
+
+Core::GeometryArena::GeometryArena() : meshCount(0), vertexArray(0), vertexBuffer(0), indexBuffer(0) {}
+
+void Core::GeometryArena::Add(aiMesh* mesh, RenderContext& context)
+{
+    // the vertex array name is needed before upload so contexts can point at it
+    if (this->vertexArray == 0)
+        glGenVertexArrays(1, &this->vertexArray);
+
+    context.vertexArray = this->vertexArray;
+    context.meshIndex = this->meshCount++;
+    context.firstIndex = (GLuint)this->indices.size();
+    context.baseVertex = (GLint)this->vertices.size();
+
+    if (mesh->mTextureCoords[0] == nullptr) {
+        std::cout << "no uv coords\n";
+    }
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        ArenaVertex vertex = {};
+        vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        if (mesh->mNormals != nullptr)
+            vertex.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        //tex coord must be converted to 2d vecs
+        if (mesh->mTextureCoords[0] != nullptr)
+            vertex.texCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        // without uv coords assimp has no tangent space to give
+        if (mesh->mTangents != nullptr && mesh->mBitangents != nullptr)
+        {
+            vertex.tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
+        this->vertices.push_back(vertex);
+    }
+
+    // indices stay relative to the mesh, the base vertex of the draw adds the offset
+    std::vector<GLuint> meshIndices;
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    {
+        const aiFace& face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++)
+            meshIndices.push_back(face.mIndices[j]);
+    }
+
+    context.size = (int)meshIndices.size();
+    context.lods[0].firstIndex = context.firstIndex;
+    context.lods[0].size = context.size;
+    context.lodCount = 1;
+    this->indices.insert(this->indices.end(), meshIndices.begin(), meshIndices.end());
+
+    // Each level is simplified from the previous one. The chain stops early when a level
+    // barely shrinks, which happens on meshes made mostly of seams and borders.
+    std::vector<glm::vec3> positions(mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        positions[i] = this->vertices[context.baseVertex + i].position;
+    size_t fullTriangles = meshIndices.size() / 3;
+    std::cout << "lod chain of " << (mesh->mName.length > 0 ? mesh->mName.C_Str() : "mesh") << " (" << mesh->mNumVertices << " vertices): " << fullTriangles;
+    for (int level = 1; level < MAX_MESH_LODS; level++)
+    {
+        size_t target = (size_t)(fullTriangles * LOD_TRIANGLE_RATIOS[level]);
+        std::vector<GLuint> lodIndices = Core::SimplifyMesh(positions, meshIndices, target);
+        if (lodIndices.empty() || lodIndices.size() > meshIndices.size() * 9 / 10)
+            break;
+
+        context.lods[level].firstIndex = (GLuint)this->indices.size();
+        context.lods[level].size = (int)lodIndices.size();
+        context.lodCount++;
+        this->indices.insert(this->indices.end(), lodIndices.begin(), lodIndices.end());
+        meshIndices.swap(lodIndices);
+        std::cout << "/" << meshIndices.size() / 3;
+    }
+    std::cout << " triangles" << (context.lodCount == 1 ? ", no level shrank enough" : "") << std::endl;
+
+    // box first, the sphere is centred on it and reaches the furthest vertex
+    if (mesh->mNumVertices > 0)
+    {
+        const ArenaVertex* meshVertices = &this->vertices[context.baseVertex];
+        context.boundsMin = context.boundsMax = meshVertices[0].position;
+        for (unsigned int i = 1; i < mesh->mNumVertices; i++)
+        {
+            context.boundsMin = glm::min(context.boundsMin, meshVertices[i].position);
+            context.boundsMax = glm::max(context.boundsMax, meshVertices[i].position);
+        }
+        context.sphereCenter = (context.boundsMin + context.boundsMax) * 0.5f;
+        context.sphereRadius = 0.f;
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+            context.sphereRadius = glm::max(context.sphereRadius, glm::length(meshVertices[i].position - context.sphereCenter));
+    }
+}
+
+void Core::GeometryArena::Upload()
+{
+    Core::BindVertexArray(this->vertexArray);
+
+    glGenBuffers(1, &this->vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(ArenaVertex), this->vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &this->indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), this->indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexBuffer(0, this->vertexBuffer, 0, sizeof(ArenaVertex));
+    const GLuint sizes[5] = { 3, 3, 2, 3, 3 };
+    const GLuint offsets[5] = {
+        offsetof(ArenaVertex, position),
+        offsetof(ArenaVertex, normal),
+        offsetof(ArenaVertex, texCoord),
+        offsetof(ArenaVertex, tangent),
+        offsetof(ArenaVertex, bitangent)
+    };
+    for (GLuint attribute = 0; attribute < 5; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribFormat(attribute, sizes[attribute], GL_FLOAT, GL_FALSE, offsets[attribute]);
+        glVertexAttribBinding(attribute, 0);
+    }
+
+    // The instance stream buffer is attached by the render queue; programs that do not
+    // read attributes 5-9 (skybox, sun) ignore them.
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glEnableVertexAttribArray(5 + column);
+        glVertexAttribFormat(5 + column, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, modelMatrix) + sizeof(glm::vec4) * column);
+        glVertexAttribBinding(5 + column, INSTANCE_BUFFER_BINDING);
+    }
+    glEnableVertexAttribArray(9);
+    glVertexAttribIFormat(9, 1, GL_UNSIGNED_INT, offsetof(InstanceData, material));
+    glVertexAttribBinding(9, INSTANCE_BUFFER_BINDING);
+    glVertexBindingDivisor(INSTANCE_BUFFER_BINDING, 1);
+
+    std::cout << "geometry arena: " << this->vertices.size() << " vertices, " << this->indices.size() << " indices ("
+        << (this->vertices.size() * sizeof(ArenaVertex) + this->indices.size() * sizeof(GLuint)) / (1024.f * 1024.f) << " MB)" << std::endl;
+
+    std::vector<ArenaVertex>().swap(this->vertices);
+    std::vector<GLuint>().swap(this->indices);
+}
+
+void Core::GeometryArena::Destroy()
+{
+    Core::BindVertexArray(0);
+    glDeleteVertexArrays(1, &this->vertexArray);
+    glDeleteBuffers(1, &this->vertexBuffer);
+    glDeleteBuffers(1, &this->indexBuffer);
+    this->vertexArray = 0;
+    this->vertexBuffer = 0;
+    this->indexBuffer = 0;
+}
+
+GLuint Core::GeometryArena::GetVertexArray() const
+{
+    return this->vertexArray;
+}
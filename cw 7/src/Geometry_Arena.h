@@ -0,0 +1,61 @@
+#pragma once
+
+#include "glew.h"
+#include "glm.hpp"
+#include "Render_Utils.h"
+#include <vector>
+#include <assimp/scene.h>
+
+namespace Core
+{
+	// Triangle share of each level of detail built at import, relative to the full mesh.
+	const float LOD_TRIANGLE_RATIOS[MAX_MESH_LODS] = { 1.f, 0.5f, 0.25f, 0.1f };
+
+	// Vertex buffer binding of the per-instance stream (attributes 5-9) in the arena's vertex array.
+	const GLuint INSTANCE_BUFFER_BINDING = 1;
+
+	// Interleaved vertex of every mesh in the arena, attributes 0-4.
+	struct ArenaVertex
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 texCoord;
+		glm::vec3 tangent;
+		glm::vec3 bitangent;
+	};
+
+	// One element of the instance stream: the model matrix in attributes 5-8 and the
+	// material index in attribute 9, padded to keep the matrices 16-byte aligned.
+	struct InstanceData
+	{
+		glm::mat4 modelMatrix;
+		GLuint material;
+		GLuint padding[3];
+	};
+
+	static_assert(sizeof(InstanceData) == 80, "InstanceData must stay 16-byte aligned");
+
+	// All scene meshes share one vertex buffer, one index buffer and one vertex array.
+	// A RenderContext only stores the range of its mesh, so draws of different meshes
+	// differ in offsets alone and can go into the same multi-draw.
+	class GeometryArena
+	{
+	public:
+		GeometryArena();
+		// Appends the mesh to the CPU-side arrays, builds its LOD chain and points the context at it.
+		void Add(aiMesh* mesh, RenderContext& context);
+		// Uploads everything added so far; meshes are not added after this.
+		void Upload();
+		void Destroy();
+
+		GLuint GetVertexArray() const;
+
+	private:
+		std::vector<ArenaVertex> vertices;
+		std::vector<GLuint> indices;
+		int meshCount;
+		GLuint vertexArray;
+		GLuint vertexBuffer;
+		GLuint indexBuffer;
+	};
+}
@@ -0,0 +1,205 @@
+#include "Gpu_Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+Core::GpuProfiler::GpuProfiler() : written(0), read(0), enabled(false)
+{
+    this->framePass = this->PassIndex("frame");
+}
+
+void Core::GpuProfiler::Init()
+{
+    // software drivers may expose the query without a clock behind it
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    this->enabled = bits > 0;
+    if (!this->enabled)
+        std::cout << "gpu profiler: timestamp queries not supported, disabled" << std::endl;
+}
+
+void Core::GpuProfiler::Destroy()
+{
+    for (FrameQueries& frame : this->frames)
+    {
+        if (!frame.queries.empty())
+            glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+        frame = FrameQueries();
+    }
+    this->frameTimes.clear();
+    this->written = this->read = 0;
+}
+
+bool Core::GpuProfiler::IsEnabled() const
+{
+    return this->enabled;
+}
+
+int Core::GpuProfiler::Query(FrameQueries& frame)
+{
+    // the query pool of a frame slot grows to the most scopes a frame had and is then reused
+    if (frame.used == (int)frame.queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+    return frame.used++;
+}
+
+int Core::GpuProfiler::PassIndex(const char* name)
+{
+    auto found = this->passIndices.find(name);
+    if (found != this->passIndices.end())
+        return found->second;
+    PassStats stats;
+    stats.name = name;
+    this->passes.push_back(stats);
+    int index = (int)this->passes.size() - 1;
+    this->passIndices[name] = index;
+    return index;
+}
+
+void Core::GpuProfiler::BeginFrame()
+{
+    if (!this->enabled)
+        return;
+    // when every slot is still in flight the oldest frame is dropped unread
+    if (this->written - this->read == FRAMES_IN_FLIGHT)
+        this->read++;
+    FrameQueries& frame = this->frames[this->written % FRAMES_IN_FLIGHT];
+    frame.used = 0;
+    frame.scopes.clear();
+    frame.open.clear();
+    this->BeginPass("frame");
+}
+
+void Core::GpuProfiler::EndFrame()
+{
+    if (!this->enabled)
+        return;
+    FrameQueries& frame = this->frames[this->written % FRAMES_IN_FLIGHT];
+    // scopes left open are closed with the frame
+    while (!frame.open.empty())
+        this->EndPass();
+    this->written++;
+}
+
+void Core::GpuProfiler::BeginPass(const char* name)
+{
+    if (!this->enabled)
+        return;
+    FrameQueries& frame = this->frames[this->written % FRAMES_IN_FLIGHT];
+    Scope scope;
+    scope.pass = this->PassIndex(name);
+    scope.begin = this->Query(frame);
+    scope.end = -1;
+    frame.open.push_back((int)frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void Core::GpuProfiler::EndPass()
+{
+    if (!this->enabled)
+        return;
+    FrameQueries& frame = this->frames[this->written % FRAMES_IN_FLIGHT];
+    if (frame.open.empty())
+        return;
+    frame.scopes[frame.open.back()].end = this->Query(frame);
+    frame.open.pop_back();
+}
+
+void Core::GpuProfiler::AddSample(int pass, float milliseconds)
+{
+    PassStats& stats = this->passes[pass];
+    stats.min = stats.frames == 0 ? milliseconds : std::min(stats.min, milliseconds);
+    stats.max = stats.frames == 0 ? milliseconds : std::max(stats.max, milliseconds);
+    stats.total += milliseconds;
+    stats.frames++;
+    if ((int)stats.samples.size() < MAX_SAMPLES)
+        stats.samples.push_back(milliseconds);
+    else
+    {
+        stats.samples[stats.nextSample] = milliseconds;
+        stats.nextSample = (stats.nextSample + 1) % MAX_SAMPLES;
+    }
+}
+
+void Core::GpuProfiler::Collect()
+{
+    if (!this->enabled)
+        return;
+    std::vector<double> sums;
+    std::vector<bool> seen;
+    while (this->read < this->written)
+    {
+        const FrameQueries& frame = this->frames[this->read % FRAMES_IN_FLIGHT];
+        // queries finish in order, so the last one of the frame stands for all of them
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        std::vector<GLuint64> times(frame.used);
+        for (int i = 0; i < frame.used; i++)
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &times[i]);
+
+        sums.assign(this->passes.size(), 0.0);
+        seen.assign(this->passes.size(), false);
+        for (const Scope& scope : frame.scopes)
+        {
+            sums[scope.pass] += (times[scope.end] - times[scope.begin]) * 1e-6;
+            seen[scope.pass] = true;
+        }
+        for (size_t pass = 0; pass < this->passes.size(); pass++)
+        {
+            if (seen[pass])
+                this->AddSample((int)pass, (float)sums[pass]);
+        }
+        this->frameTimes.push_back((float)(sums[this->framePass] * 1e-3));
+        this->read++;
+    }
+}
+
+bool Core::GpuProfiler::ReadFrameTime(float& seconds)
+{
+    if (this->frameTimes.empty())
+        return false;
+    seconds = this->frameTimes.front();
+    this->frameTimes.pop_front();
+    return true;
+}
+
+std::vector<Core::GpuPassTiming> Core::GpuProfiler::GetTimings() const
+{
+    std::vector<GpuPassTiming> timings;
+    for (const PassStats& stats : this->passes)
+    {
+        if (stats.frames == 0)
+            continue;
+        std::vector<float> sorted = stats.samples;
+        size_t rank = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        timings.push_back({ stats.name, stats.frames, stats.min, (float)(stats.total / stats.frames), sorted[rank], stats.max });
+    }
+    return timings;
+}
+
+bool Core::GpuProfiler::WriteCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "gpu profiler: cannot write " << path << std::endl;
+        return false;
+    }
+    file << "pass,frames,min_ms,avg_ms,p99_ms,max_ms\n";
+    for (const GpuPassTiming& timing : this->GetTimings())
+    {
+        file << "\"" << timing.name << "\"," << timing.frames << "," << timing.min << "," << timing.average << ","
+            << timing.p99 << "," << timing.max << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "glew.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+	// Aggregated GPU time of one named pass over the recorded frames, in milliseconds.
+	// Passes that run several times in a frame (the Gaussian blur) count as their sum.
+	struct GpuPassTiming
+	{
+		std::string name;
+		int frames;
+		float min;
+		float average;
+		float p99;
+		float max;
+	};
+
+	// Per-pass GPU times from pairs of timestamp queries around each pass. The queries of a
+	// frame are read a few frames later, only once all of them are available, so profiling
+	// never stalls the pipeline. Timestamps rather than GL_TIME_ELAPSED let passes nest, which
+	// only one elapsed query at a time would not. The "frame" scope doubles as the frame time
+	// the dynamic resolution and the benchmark are fed with.
+	class GpuProfiler
+	{
+	public:
+		GpuProfiler();
+		// Disables itself when the driver gives timestamps no bits.
+		void Init();
+		void Destroy();
+		bool IsEnabled() const;
+
+		void BeginFrame();
+		void EndFrame();
+		// Scopes with the same name share statistics; scopes may nest.
+		void BeginPass(const char* name);
+		void EndPass();
+
+		// Reads every finished frame into the statistics.
+		void Collect();
+		// GPU time in seconds of a frame Collect read, oldest first; each frame is given once.
+		bool ReadFrameTime(float& seconds);
+		// Passes in order of first appearance, plus "frame" for the whole frame.
+		std::vector<GpuPassTiming> GetTimings() const;
+		// One line per pass: name, frames, min, avg, p99 and max in milliseconds.
+		bool WriteCsv(const std::string& path) const;
+
+	private:
+		static const int FRAMES_IN_FLIGHT = 4;
+		// samples kept per pass for the percentile; min, average and max cover every frame
+		static const int MAX_SAMPLES = 4096;
+
+		struct Scope
+		{
+			int pass;
+			int begin;
+			int end;
+		};
+
+		struct FrameQueries
+		{
+			std::vector<GLuint> queries;
+			int used = 0;
+			std::vector<Scope> scopes;
+			std::vector<int> open;
+		};
+
+		struct PassStats
+		{
+			std::string name;
+			int frames = 0;
+			double total = 0.0;
+			float min = 0.f;
+			float max = 0.f;
+			std::vector<float> samples;
+			int nextSample = 0;
+		};
+
+		int Query(FrameQueries& frame);
+		int PassIndex(const char* name);
+		void AddSample(int pass, float milliseconds);
+
+		FrameQueries frames[FRAMES_IN_FLIGHT];
+		std::vector<PassStats> passes;
+		std::map<std::string, int> passIndices;
+		int framePass;
+		std::deque<float> frameTimes;
+		int written;
+		int read;
+		bool enabled;
+	};
+}
@@ -0,0 +1,123 @@
+#include "Input_Recorder.h"
+
+#include <iostream>
+
+namespace
+{
+    const char MAGIC[4] = { 'G', 'R', 'K', 'I' };
+    const uint32_t VERSION = 1;
+
+    // the file is written in the byte order of the machine; recordings stay on one platform
+    template <typename T>
+    void WriteValue(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadValue(std::ifstream& file, T& value)
+    {
+        return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+}
+
+uint64_t Core::HashBytes(const void* data, size_t size, uint64_t hash)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool Core::InputRecorder::Open(const std::string& path)
+{
+    this->file.open(path, std::ios::binary);
+    if (!this->file)
+    {
+        std::cerr << "input recorder: cannot write " << path << std::endl;
+        return false;
+    }
+    this->frames = 0;
+    this->file.write(MAGIC, sizeof(MAGIC));
+    WriteValue(this->file, VERSION);
+    WriteValue(this->file, this->frames);
+    WriteValue(this->file, (uint64_t)0);
+    WriteValue(this->file, (uint32_t)0);
+    return true;
+}
+
+bool Core::InputRecorder::IsOpen() const
+{
+    return this->file.is_open();
+}
+
+void Core::InputRecorder::Write(const FrameInput& input)
+{
+    WriteValue(this->file, input.time);
+    WriteValue(this->file, input.keys);
+    WriteValue(this->file, input.mouseDeltaX);
+    WriteValue(this->file, input.mouseDeltaY);
+    this->frames++;
+}
+
+void Core::InputRecorder::Close(uint64_t finalStateHash)
+{
+    if (!this->file.is_open())
+        return;
+    this->file.seekp(sizeof(MAGIC) + sizeof(VERSION));
+    WriteValue(this->file, this->frames);
+    WriteValue(this->file, finalStateHash);
+    this->file.close();
+    std::cout << "input recorder: " << this->frames << " frames, final state " << std::hex << finalStateHash << std::dec << std::endl;
+}
+
+bool Core::InputReplay::Open(const std::string& path)
+{
+    this->file.open(path, std::ios::binary);
+    char magic[4];
+    uint32_t version, reserved;
+    if (!this->file || !this->file.read(magic, sizeof(magic)) || !ReadValue(this->file, version) ||
+        std::string(magic, 4) != std::string(MAGIC, 4) || version != VERSION ||
+        !ReadValue(this->file, this->frames) || !ReadValue(this->file, this->finalStateHash) || !ReadValue(this->file, reserved))
+    {
+        std::cerr << "input replay: " << path << " is not an input recording" << std::endl;
+        this->file.close();
+        return false;
+    }
+    this->read = 0;
+    std::cout << "input replay: " << this->frames << " frames from " << path << std::endl;
+    return true;
+}
+
+bool Core::InputReplay::IsOpen() const
+{
+    return this->file.is_open();
+}
+
+bool Core::InputReplay::Next(FrameInput& input)
+{
+    if (this->read >= this->frames)
+        return false;
+    if (!ReadValue(this->file, input.time) || !ReadValue(this->file, input.keys) ||
+        !ReadValue(this->file, input.mouseDeltaX) || !ReadValue(this->file, input.mouseDeltaY))
+    {
+        std::cerr << "input replay: recording ends after " << this->read << " frames" << std::endl;
+        this->read = this->frames;
+        return false;
+    }
+    this->read++;
+    return true;
+}
+
+uint32_t Core::InputReplay::GetFrameCount() const
+{
+    return this->frames;
+}
+
+uint64_t Core::InputReplay::GetFinalStateHash() const
+{
+    return this->finalStateHash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace Core
+{
+	// Bits of FrameInput::keys, one per key the game reads.
+	enum InputKey
+	{
+		INPUT_KEY_ESCAPE = 1 << 0,
+		INPUT_KEY_X = 1 << 1,
+		INPUT_KEY_W = 1 << 2,
+		INPUT_KEY_S = 1 << 3,
+		INPUT_KEY_TAB = 1 << 4,
+		INPUT_KEY_B = 1 << 5,
+		INPUT_KEY_P = 1 << 6,
+		INPUT_KEY_SPACE = 1 << 7
+	};
+
+	// Everything the simulation reads from the outside in one frame. The game time is kept
+	// instead of its delta so a replay computes the delta with the same rounding.
+	struct FrameInput
+	{
+		float time = 0.f;
+		uint16_t keys = 0;
+		float mouseDeltaX = 0.f;
+		float mouseDeltaY = 0.f;
+
+		bool IsDown(InputKey key) const { return (keys & key) != 0; }
+	};
+
+	// FNV-1a, for comparing the simulation state at the end of a recording and of its replay.
+	uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+	// Writes frames into a binary file: a 24-byte header (magic, version, frame count and the
+	// state hash at the end of the recording) followed by 14 bytes per frame.
+	class InputRecorder
+	{
+	public:
+		bool Open(const std::string& path);
+		bool IsOpen() const;
+		void Write(const FrameInput& input);
+		// Fills in the header; finalStateHash is checked by the replay.
+		void Close(uint64_t finalStateHash);
+
+	private:
+		std::ofstream file;
+		uint32_t frames = 0;
+	};
+
+	class InputReplay
+	{
+	public:
+		bool Open(const std::string& path);
+		bool IsOpen() const;
+		// Returns false once every recorded frame was given.
+		bool Next(FrameInput& input);
+		uint32_t GetFrameCount() const;
+		uint64_t GetFinalStateHash() const;
+
+	private:
+		std::ifstream file;
+		uint32_t frames = 0;
+		uint32_t read = 0;
+		uint64_t finalStateHash = 0;
+	};
+}
@@ -0,0 +1,191 @@
+#include "Job_System.h"
+
+#include <algorithm>
+
+namespace
+{
+    // The system whose worker the calling thread is, and that worker's queue.
+    thread_local const Core::JobSystem* currentSystem = nullptr;
+    thread_local int currentQueue = 0;
+}
+
+Core::JobSystem::JobSystem() : queuedJobs(0), stopping(false)
+{
+}
+
+Core::JobSystem::~JobSystem()
+{
+    this->Shutdown();
+}
+
+void Core::JobSystem::Init(int workerCount)
+{
+    this->Shutdown();
+    if (workerCount < 0)
+        workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+
+    this->mainThread = std::this_thread::get_id();
+    this->stopping = false;
+    this->queues.clear();
+    for (int queue = 0; queue <= workerCount; queue++)
+        this->queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    for (int worker = 1; worker <= workerCount; worker++)
+        this->workers.push_back(std::thread(&JobSystem::WorkerLoop, this, worker));
+}
+
+void Core::JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+    this->wakeUp.notify_all();
+    for (std::thread& worker : this->workers)
+        worker.join();
+    this->workers.clear();
+}
+
+int Core::JobSystem::GetThreadCount() const
+{
+    return (int)this->workers.size() + 1;
+}
+
+int Core::JobSystem::GetQueueOfThisThread() const
+{
+    return currentSystem == this ? currentQueue : 0;
+}
+
+void Core::JobSystem::Run(Job job, JobCounter* counter)
+{
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    WorkerQueue& queue = *this->queues[this->GetQueueOfThisThread()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::make_pair(std::move(job), counter));
+    }
+    this->queuedJobs.fetch_add(1, std::memory_order_release);
+    if (this->workers.empty())
+        return;
+    // taking the lock orders the count before a worker that is about to sleep checks it
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+    this->wakeUp.notify_one();
+}
+
+void Core::JobSystem::RunOnMainThread(Job job, JobCounter* counter)
+{
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(this->mainThreadMutex);
+    this->mainThreadJobs.push_back(std::make_pair(std::move(job), counter));
+}
+
+void Core::JobSystem::RunMainThreadJobs()
+{
+    std::vector<std::pair<Job, JobCounter*>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(this->mainThreadMutex);
+        jobs.swap(this->mainThreadJobs);
+    }
+    for (auto& job : jobs)
+    {
+        job.first();
+        this->Finish(job.second);
+    }
+}
+
+bool Core::JobSystem::TryRunJob(int queue)
+{
+    std::pair<Job, JobCounter*> job;
+    bool found = false;
+    // own jobs newest first, they are the ones still warm in cache
+    {
+        WorkerQueue& own = *this->queues[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+    // then the oldest job of another thread, usually the largest piece of its work
+    for (size_t i = 1; !found && i < this->queues.size(); i++)
+    {
+        WorkerQueue& victim = *this->queues[(queue + i) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+    if (!found)
+        return false;
+
+    this->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job.first();
+    this->Finish(job.second);
+    return true;
+}
+
+void Core::JobSystem::Finish(JobCounter* counter)
+{
+    if (counter)
+        counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void Core::JobSystem::Wait(JobCounter& counter)
+{
+    int queue = this->GetQueueOfThisThread();
+    bool onMainThread = std::this_thread::get_id() == this->mainThread;
+    while (!counter.IsDone())
+    {
+        if (onMainThread)
+            this->RunMainThreadJobs();
+        if (!this->TryRunJob(queue))
+            std::this_thread::yield();
+    }
+}
+
+void Core::JobSystem::ParallelFor(int count, int grain, const std::function<void(int, int)>& body)
+{
+    grain = std::max(1, grain);
+    if (count <= grain || this->workers.empty())
+    {
+        if (count > 0)
+            body(0, count);
+        return;
+    }
+
+    // a few ranges per thread, so stealing evens out ranges that take longer
+    int rangeSize = std::max(grain, (count + this->GetThreadCount() * 4 - 1) / (this->GetThreadCount() * 4));
+    JobCounter counter;
+    for (int begin = rangeSize; begin < count; begin += rangeSize)
+    {
+        int end = std::min(count, begin + rangeSize);
+        this->Run([&body, begin, end]() { body(begin, end); }, &counter);
+    }
+    body(0, std::min(count, rangeSize));
+    this->Wait(counter);
+}
+
+void Core::JobSystem::WorkerLoop(int queue)
+{
+    currentSystem = this;
+    currentQueue = queue;
+    while (true)
+    {
+        if (this->TryRunJob(queue))
+            continue;
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wakeUp.wait(lock, [this]() {
+            return this->stopping.load() || this->queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+        if (this->stopping)
+            return;
+    }
+}
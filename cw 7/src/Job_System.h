@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+	typedef std::function<void()> Job;
+
+	// Number of jobs still to finish; every job given the counter adds one and takes it away
+	// when it is done, so a Wait on the counter waits for all of them.
+	class JobCounter
+	{
+	public:
+		JobCounter() : pending(0) {}
+		bool IsDone() const { return this->pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<int> pending;
+	};
+
+	// Work-stealing scheduler. Every worker thread and the thread that called Init own a deque:
+	// they push and pop at its back, idle workers steal from the front of the others'. Jobs
+	// pushed from any other thread go to the main thread's deque and are stolen from there.
+	// GL calls only work on the main thread, so those go through RunOnMainThread instead.
+	class JobSystem
+	{
+	public:
+		JobSystem();
+		~JobSystem();
+
+		// Starts the worker threads; -1 starts one per hardware thread besides the main one.
+		// With no workers every job runs on the main thread inside Wait.
+		void Init(int workerCount = -1);
+		void Shutdown();
+		// Threads running jobs, the main thread included.
+		int GetThreadCount() const;
+
+		void Run(Job job, JobCounter* counter = nullptr);
+		// Runs the job on the main thread, the next time it waits or calls RunMainThreadJobs.
+		void RunOnMainThread(Job job, JobCounter* counter = nullptr);
+		void RunMainThreadJobs();
+
+		// Runs jobs, stolen ones included, until the counter's jobs are done. On the main
+		// thread it runs the main-thread jobs as well.
+		void Wait(JobCounter& counter);
+
+		// Calls body(begin, end) over [0, count) in ranges of at least grain items and returns
+		// when all ranges are done. A count up to grain runs inline, without any job.
+		void ParallelFor(int count, int grain, const std::function<void(int, int)>& body);
+
+	private:
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<std::pair<Job, JobCounter*>> jobs;
+		};
+
+		void WorkerLoop(int queue);
+		int GetQueueOfThisThread() const;
+		bool TryRunJob(int queue);
+		void Finish(JobCounter* counter);
+
+		// queue 0 belongs to the main thread, queue i to worker i
+		std::vector<std::unique_ptr<WorkerQueue>> queues;
+		std::vector<std::thread> workers;
+		std::thread::id mainThread;
+
+		std::mutex mainThreadMutex;
+		std::vector<std::pair<Job, JobCounter*>> mainThreadJobs;
+
+		// idle workers sleep until a job is queued
+		std::mutex sleepMutex;
+		std::condition_variable wakeUp;
+		std::atomic<int> queuedJobs;
+		std::atomic<bool> stopping;
+	};
+}
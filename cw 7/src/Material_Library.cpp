@@ -0,0 +1,196 @@
+#include "Material_Library.h"
+#include "Cpu_Profiler.h"
+#include "Render_State.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // The first layers of the array hold the neutral maps, in this order.
+    enum DefaultLayer
+    {
+        LAYER_WHITE = 0,
+        LAYER_FLAT_NORMAL,
+        LAYER_BLACK,
+        DEFAULT_LAYER_COUNT
+    };
+
+    const unsigned char DEFAULT_COLORS[DEFAULT_LAYER_COUNT][4] = {
+        { 255, 255, 255, 255 },
+        { 128, 128, 255, 255 },
+        { 0, 0, 0, 255 }
+    };
+
+    const int SLOT_FALLBACKS[Core::MAX_MATERIAL_TEXTURES] = {
+        LAYER_WHITE, LAYER_FLAT_NORMAL, LAYER_WHITE, LAYER_WHITE, LAYER_BLACK
+    };
+}
+
+Core::MaterialLibrary::MaterialLibrary() : textureArray(0), materialBuffer(0)
+{
+    for (int layer = 0; layer < DEFAULT_LAYER_COUNT; layer++)
+    {
+        this->layerPaths.push_back("");
+        this->layerFallbacks.push_back(layer);
+    }
+}
+
+int Core::MaterialLibrary::Add(const std::string paths[MAX_MATERIAL_TEXTURES], float bloomThreshold)
+{
+    MaterialData material;
+    for (int slot = 0; slot < MAX_MATERIAL_TEXTURES; slot++)
+        material.layers[slot] = this->AddLayer(paths[slot], SLOT_FALLBACKS[slot]);
+    material.bloomThreshold = bloomThreshold;
+
+    this->materials.push_back(material);
+    return (int)this->materials.size() - 1;
+}
+
+int Core::MaterialLibrary::AddLayer(const std::string& path, int fallbackLayer)
+{
+    if (path.empty())
+        return fallbackLayer;
+
+    // maps shared between materials (the circles, the asteroid's ao) get a single layer
+    auto it = this->layerIndices.find(path);
+    if (it != this->layerIndices.end())
+        return it->second;
+
+    int layer = (int)this->layerPaths.size();
+    this->layerPaths.push_back(path);
+    this->layerFallbacks.push_back(fallbackLayer);
+    this->layerIndices[path] = layer;
+    return layer;
+}
+
+void Core::MaterialLibrary::Build(JobSystem& jobs)
+{
+    PROFILE_FUNCTION();
+    int layerCount = (int)this->layerPaths.size();
+    int levels = 1 + (int)std::floor(std::log2((float)MATERIAL_LAYER_SIZE));
+
+    glGenTextures(1, &this->textureArray);
+    Core::BindTexture(GL_TEXTURE_2D_ARRAY, this->textureArray);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, MATERIAL_LAYER_SIZE, MATERIAL_LAYER_SIZE, layerCount);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    JobCounter loaded;
+    for (int layer = 0; layer < layerCount; layer++)
+    {
+        const std::string& path = this->layerPaths[layer];
+        if (path.empty())
+        {
+            this->FillLayer(layer, DEFAULT_COLORS[this->layerFallbacks[layer]]);
+            continue;
+        }
+        jobs.Run([this, &jobs, &loaded, &framebuffers, &path, layer]() {
+            ImageData image = DecodeImage(path.c_str());
+            // the upload job joins the counter before the decode job leaves it
+            jobs.RunOnMainThread([this, &framebuffers, &path, layer, image]() mutable {
+                if (image.pixels)
+                    this->UploadLayer(image, layer, framebuffers[0], framebuffers[1]);
+                else
+                {
+                    std::cerr << "Error loading image: " << path << std::endl;
+                    this->FillLayer(layer, DEFAULT_COLORS[this->layerFallbacks[layer]]);
+                }
+                FreeImage(image);
+            }, &loaded);
+        }, &loaded);
+    }
+    jobs.Wait(loaded);
+    Core::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    Core::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, framebuffers);
+
+    Core::BindTexture(GL_TEXTURE_2D_ARRAY, this->textureArray);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glGenBuffers(1, &this->materialBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->materialBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, this->materials.size() * sizeof(MaterialData), this->materials.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, this->materialBuffer);
+
+    float layerMegabytes = MATERIAL_LAYER_SIZE * MATERIAL_LAYER_SIZE * 4 * 4 / 3.f / (1024.f * 1024.f);
+    std::cout << "materials: " << this->materials.size() << " materials in " << layerCount << " layers ("
+        << layerCount * layerMegabytes << " MB)" << std::endl;
+}
+
+void Core::MaterialLibrary::UploadLayer(const ImageData& image, int layer, GLuint readFramebuffer, GLuint drawFramebuffer)
+{
+    int w = image.width, h = image.height;
+    GLuint source;
+    glGenTextures(1, &source);
+    Core::BindTexture(GL_TEXTURE_2D, source);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+
+    // A linear blit only reads 2x2 texels, so large maps are first reduced through
+    // their own mip chain to the last level that is still at least the layer size.
+    int level = 0;
+    while ((std::max(w, h) >> (level + 1)) >= MATERIAL_LAYER_SIZE)
+        level++;
+    if (level > 0)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    Core::BindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, level);
+    Core::BindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, this->textureArray, 0, layer);
+    glBlitFramebuffer(0, 0, std::max(1, w >> level), std::max(1, h >> level),
+        0, 0, MATERIAL_LAYER_SIZE, MATERIAL_LAYER_SIZE, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    // unbind before deleting, the tracker would otherwise keep the name and filter a later bind of a reused one
+    Core::BindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &source);
+}
+
+void Core::MaterialLibrary::FillLayer(int layer, const unsigned char color[4])
+{
+    std::vector<unsigned char> pixels(MATERIAL_LAYER_SIZE * MATERIAL_LAYER_SIZE * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4)
+        std::copy(color, color + 4, pixels.begin() + i);
+
+    Core::BindTexture(GL_TEXTURE_2D_ARRAY, this->textureArray);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, MATERIAL_LAYER_SIZE, MATERIAL_LAYER_SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+void Core::MaterialLibrary::Destroy()
+{
+    Core::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glDeleteTextures(1, &this->textureArray);
+    glDeleteBuffers(1, &this->materialBuffer);
+    this->textureArray = 0;
+    this->materialBuffer = 0;
+}
+
+GLuint Core::MaterialLibrary::GetTextureArray() const
+{
+    return this->textureArray;
+}
+
+int Core::MaterialLibrary::GetMaterialCount() const
+{
+    return (int)this->materials.size();
+}
+
+int Core::MaterialLibrary::GetLayerCount() const
+{
+    return (int)this->layerPaths.size();
+}
+
+const std::vector<std::string>& Core::MaterialLibrary::GetLayerPaths() const
+{
+    return this->layerPaths;
+}
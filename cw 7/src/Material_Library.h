@@ -0,0 +1,75 @@
+#pragma once
+
+#include "glew.h"
+#include "Job_System.h"
+#include "Shader_Loader.h"
+#include "Texture.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+	enum MaterialSlot
+	{
+		MATERIAL_ALBEDO = 0,
+		MATERIAL_NORMAL,
+		MATERIAL_AO,
+		MATERIAL_ROUGHNESS,
+		MATERIAL_METALLIC,
+		MAX_MATERIAL_TEXTURES
+	};
+
+	// Binding point of the MaterialTable storage block in shader_default and shader_sun.
+	const GLuint MATERIALS_BINDING = 1;
+	// Every map is resampled to this size so all of them fit in one texture array.
+	const int MATERIAL_LAYER_SIZE = 1024;
+	// Luminance above which a lit surface starts to bloom; emissive materials go lower.
+	const float DEFAULT_BLOOM_THRESHOLD = 0.9f;
+
+	// Mirrors the std430 Material struct: the array layer of each map and the bloom
+	// threshold the scene shaders write to the alpha of the HDR target for the bright pass.
+	struct MaterialData
+	{
+		GLint layers[MAX_MATERIAL_TEXTURES];
+		float bloomThreshold;
+	};
+
+	static_assert(sizeof(MaterialData) == 24, "MaterialData must match the std430 Material struct");
+
+	// Packs the maps of all materials into layers of a single GL_TEXTURE_2D_ARRAY and
+	// keeps the layer table in a shader storage buffer, so switching materials between
+	// draws is an index change instead of five texture binds.
+	class MaterialLibrary
+	{
+	public:
+		MaterialLibrary();
+		// Queues the maps of one material and returns its index. Empty paths and files that
+		// fail to load fall back to neutral layers (white, flat normal, black metallic).
+		int Add(const std::string paths[MAX_MATERIAL_TEXTURES], float bloomThreshold = DEFAULT_BLOOM_THRESHOLD);
+		// Loads every queued map, resamples it into its layer and uploads the material table.
+		// The files are decoded on the job system; each layer is uploaded on the main thread
+		// as soon as its image is ready, while the others are still decoding.
+		void Build(JobSystem& jobs);
+		void Destroy();
+
+		GLuint GetTextureArray() const;
+		int GetMaterialCount() const;
+		int GetLayerCount() const;
+		// File of each layer, empty for the neutral ones.
+		const std::vector<std::string>& GetLayerPaths() const;
+
+	private:
+		int AddLayer(const std::string& path, int fallbackLayer);
+		void UploadLayer(const ImageData& image, int layer, GLuint readFramebuffer, GLuint drawFramebuffer);
+		void FillLayer(int layer, const unsigned char color[4]);
+
+		std::vector<std::string> layerPaths;
+		// neutral layer used when the map at the same index is missing
+		std::vector<int> layerFallbacks;
+		std::map<std::string, int> layerIndices;
+		std::vector<MaterialData> materials;
+		GLuint textureArray;
+		GLuint materialBuffer;
+	};
+}
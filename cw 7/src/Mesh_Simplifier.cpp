@@ -0,0 +1,207 @@
+#include "Mesh_Simplifier.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    // Symmetric 4x4 error matrix, upper triangle stored row by row.
+    struct Quadric
+    {
+        double m[10] = {};
+
+        void AddPlane(const glm::dvec4& p, double weight)
+        {
+            m[0] += weight * p.x * p.x; m[1] += weight * p.x * p.y; m[2] += weight * p.x * p.z; m[3] += weight * p.x * p.w;
+            m[4] += weight * p.y * p.y; m[5] += weight * p.y * p.z; m[6] += weight * p.y * p.w;
+            m[7] += weight * p.z * p.z; m[8] += weight * p.z * p.w;
+            m[9] += weight * p.w * p.w;
+        }
+
+        void Add(const Quadric& other)
+        {
+            for (int i = 0; i < 10; i++) m[i] += other.m[i];
+        }
+
+        // v^T Q v for v = (x, y, z, 1)
+        double Evaluate(const glm::vec3& v) const
+        {
+            double x = v.x, y = v.y, z = v.z;
+            return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+                + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+                + m[7] * z * z + 2 * m[8] * z
+                + m[9];
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        GLuint from;
+        GLuint to;
+        unsigned fromVersion;
+        unsigned toVersion;
+
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    uint64_t EdgeKey(GLuint a, GLuint b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    glm::vec3 TriangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        return glm::cross(b - a, c - a);
+    }
+}
+
+std::vector<GLuint> Core::SimplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, size_t targetTriangleCount)
+{
+    size_t vertexCount = positions.size();
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount <= targetTriangleCount)
+        return indices;
+
+    std::vector<GLuint> triangles(indices.begin(), indices.begin() + triangleCount * 3);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    std::vector<std::vector<GLuint>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    std::unordered_map<uint64_t, int> edgeUses;
+
+    for (GLuint t = 0; t < triangleCount; t++)
+    {
+        const GLuint* v = &triangles[t * 3];
+        for (int i = 0; i < 3; i++)
+        {
+            vertexTriangles[v[i]].push_back(t);
+            edgeUses[EdgeKey(v[i], v[(i + 1) % 3])]++;
+        }
+
+        glm::vec3 normal = TriangleNormal(positions[v[0]], positions[v[1]], positions[v[2]]);
+        float doubleArea = glm::length(normal);
+        if (doubleArea <= 0.f)
+            continue;
+        normal /= doubleArea;
+        glm::dvec4 plane(normal, -glm::dot(normal, positions[v[0]]));
+        // area weighting keeps large flat regions from being eaten by many small triangles
+        for (int i = 0; i < 3; i++)
+            quadrics[v[i]].AddPlane(plane, doubleArea * 0.5);
+    }
+
+    std::vector<bool> locked(vertexCount, false);
+    for (const auto& edge : edgeUses)
+    {
+        if (edge.second == 1)
+        {
+            locked[edge.first >> 32] = true;
+            locked[edge.first & 0xFFFFFFFF] = true;
+        }
+    }
+    std::vector<GLuint> byPosition(vertexCount);
+    for (GLuint v = 0; v < vertexCount; v++) byPosition[v] = v;
+    auto lessPosition = [&](GLuint a, GLuint b) {
+        const glm::vec3& p = positions[a];
+        const glm::vec3& q = positions[b];
+        return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+    };
+    std::sort(byPosition.begin(), byPosition.end(), lessPosition);
+    for (size_t i = 1; i < vertexCount; i++)
+    {
+        if (positions[byPosition[i]] == positions[byPosition[i - 1]])
+        {
+            locked[byPosition[i]] = true;
+            locked[byPosition[i - 1]] = true;
+        }
+    }
+
+    std::vector<unsigned> versions(vertexCount, 0);
+    std::vector<bool> removed(vertexCount, false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    // pushes the cheaper direction of the edge, if either end may move
+    auto pushEdge = [&](GLuint a, GLuint b) {
+        if (locked[a] && locked[b])
+            return;
+        Quadric sum = quadrics[a];
+        sum.Add(quadrics[b]);
+        double costAB = locked[a] ? 0.0 : sum.Evaluate(positions[b]);
+        double costBA = locked[b] ? 0.0 : sum.Evaluate(positions[a]);
+        if (!locked[a] && (locked[b] || costAB <= costBA))
+            heap.push({ costAB, a, b, versions[a], versions[b] });
+        else
+            heap.push({ costBA, b, a, versions[b], versions[a] });
+    };
+
+    for (const auto& edge : edgeUses)
+        pushEdge((GLuint)(edge.first >> 32), (GLuint)(edge.first & 0xFFFFFFFF));
+
+    size_t liveTriangles = triangleCount;
+    std::unordered_set<GLuint> neighbours;
+    while (liveTriangles > targetTriangleCount && !heap.empty())
+    {
+        Collapse collapse = heap.top();
+        heap.pop();
+        if (removed[collapse.from] || removed[collapse.to] ||
+            versions[collapse.from] != collapse.fromVersion || versions[collapse.to] != collapse.toVersion)
+            continue;
+
+        // reject collapses that would fold a surviving triangle over
+        bool flips = false;
+        for (GLuint t : vertexTriangles[collapse.from])
+        {
+            if (!triangleAlive[t]) continue;
+            GLuint* v = &triangles[t * 3];
+            if (v[0] == collapse.to || v[1] == collapse.to || v[2] == collapse.to) continue;
+
+            glm::vec3 before = TriangleNormal(positions[v[0]], positions[v[1]], positions[v[2]]);
+            glm::vec3 moved[3];
+            for (int i = 0; i < 3; i++) moved[i] = positions[v[i] == collapse.from ? collapse.to : v[i]];
+            glm::vec3 after = TriangleNormal(moved[0], moved[1], moved[2]);
+            if (glm::dot(before, after) <= 0.f) { flips = true; break; }
+        }
+        if (flips)
+            continue;
+
+        for (GLuint t : vertexTriangles[collapse.from])
+        {
+            if (!triangleAlive[t]) continue;
+            GLuint* v = &triangles[t * 3];
+            if (v[0] == collapse.to || v[1] == collapse.to || v[2] == collapse.to)
+            {
+                triangleAlive[t] = false;
+                liveTriangles--;
+                continue;
+            }
+            for (int i = 0; i < 3; i++)
+                if (v[i] == collapse.from) v[i] = collapse.to;
+            vertexTriangles[collapse.to].push_back(t);
+        }
+        removed[collapse.from] = true;
+        quadrics[collapse.to].Add(quadrics[collapse.from]);
+        versions[collapse.to]++;
+
+        // every edge at the surviving vertex now has a new cost
+        neighbours.clear();
+        for (GLuint t : vertexTriangles[collapse.to])
+        {
+            if (!triangleAlive[t]) continue;
+            for (int i = 0; i < 3; i++)
+                if (triangles[t * 3 + i] != collapse.to) neighbours.insert(triangles[t * 3 + i]);
+        }
+        for (GLuint neighbour : neighbours)
+            pushEdge(collapse.to, neighbour);
+    }
+
+    std::vector<GLuint> result;
+    result.reserve(liveTriangles * 3);
+    for (GLuint t = 0; t < triangleCount; t++)
+    {
+        if (triangleAlive[t])
+            result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    }
+    return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "glew.h"
+#include "glm.hpp"
+#include <vector>
+
+namespace Core
+{
+	// Quadric error metric edge collapse (Garland-Heckbert) that only collapses onto existing
+	// vertices, so the result indexes the same vertex array and a LOD is just another index range.
+	// Vertices on open borders and on attribute seams (same position, another vertex) never move,
+	// which can stop the mesh short of the target. The input has to be welded: with a vertex
+	// per face corner every vertex is on a border and nothing collapses.
+	std::vector<GLuint> SimplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, size_t targetTriangleCount);
+}
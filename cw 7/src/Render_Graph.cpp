@@ -0,0 +1,392 @@
+#include "Render_Graph.h"
+#include "Render_State.h"
+
+#include <iostream>
+
+namespace
+{
+    // frames an unused pooled texture survives, so sizes that come back soon are not reallocated
+    const int POOL_KEEP_FRAMES = 3;
+
+    bool SameDesc(const Core::GraphTextureDesc& a, const Core::GraphTextureDesc& b)
+    {
+        return a.width == b.width && a.height == b.height && a.format.internalFormat == b.format.internalFormat;
+    }
+
+    size_t DescBytes(const Core::GraphTextureDesc& desc)
+    {
+        return (size_t)desc.width * desc.height * desc.format.bytesPerTexel;
+    }
+}
+
+Core::RenderPassBuilder::RenderPassBuilder(RenderGraph* graph, int pass) : graph(graph), pass(pass) {}
+
+Core::GraphResource Core::RenderPassBuilder::Create(const std::string& name, const GraphTextureDesc& desc)
+{
+    RenderGraph::Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = false;
+    resource.readers = 0;
+    resource.firstPass = -1;
+    resource.lastPass = -1;
+    resource.physical = -1;
+    this->graph->resources.push_back(resource);
+
+    GraphResource handle = (GraphResource)this->graph->resources.size() - 1;
+    this->graph->passes[this->pass].writes.push_back(handle);
+    return handle;
+}
+
+Core::GraphResource Core::RenderPassBuilder::Read(GraphResource resource)
+{
+    this->graph->passes[this->pass].reads.push_back(resource);
+    return resource;
+}
+
+Core::GraphResource Core::RenderPassBuilder::Write(GraphResource resource)
+{
+    this->graph->passes[this->pass].writes.push_back(resource);
+    return resource;
+}
+
+Core::RenderPassBuilder& Core::RenderPassBuilder::SideEffect()
+{
+    this->graph->passes[this->pass].sideEffect = true;
+    return *this;
+}
+
+void Core::RenderPassBuilder::Execute(std::function<void(const RenderGraph&)> execute)
+{
+    this->graph->passes[this->pass].execute = execute;
+}
+
+Core::RenderGraph::RenderGraph() : frame(0), reportRequested(false) {}
+
+void Core::RenderGraph::Destroy()
+{
+    Core::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    for (const auto& framebuffer : this->framebuffers)
+        glDeleteFramebuffers(1, &framebuffer.second);
+    for (const PhysicalTexture& texture : this->pool)
+        glDeleteTextures(1, &texture.texture);
+    this->framebuffers.clear();
+    this->pool.clear();
+    Core::InvalidateRenderState();
+}
+
+Core::RenderPassBuilder Core::RenderGraph::AddPass(const std::string& name)
+{
+    Pass pass;
+    pass.name = name;
+    pass.sideEffect = false;
+    pass.culled = false;
+    pass.references = 0;
+    this->passes.push_back(pass);
+    return RenderPassBuilder(this, (int)this->passes.size() - 1);
+}
+
+Core::GraphResource Core::RenderGraph::ImportBackbuffer(int width, int height)
+{
+    Resource resource;
+    resource.name = "backbuffer";
+    resource.desc = { width, height, TARGET_RGBA16F };
+    resource.imported = true;
+    resource.readers = 0;
+    resource.firstPass = -1;
+    resource.lastPass = -1;
+    resource.physical = -1;
+    this->resources.push_back(resource);
+    return (GraphResource)this->resources.size() - 1;
+}
+
+void Core::RenderGraph::Cull()
+{
+    for (Resource& resource : this->resources)
+        resource.readers = 0;
+    for (Pass& pass : this->passes)
+    {
+        for (GraphResource read : pass.reads)
+            this->resources[read].readers++;
+        pass.references = (int)pass.writes.size();
+        pass.culled = false;
+        // writing the default framebuffer is visible outside the graph
+        for (GraphResource write : pass.writes)
+            if (this->resources[write].imported) pass.sideEffect = true;
+    }
+
+    // Resources nobody reads release their writers; a writer left with no used output
+    // is culled and releases what it reads in turn.
+    std::vector<GraphResource> unread;
+    for (GraphResource r = 0; r < (GraphResource)this->resources.size(); r++)
+        if (this->resources[r].readers == 0 && !this->resources[r].imported) unread.push_back(r);
+    while (!unread.empty())
+    {
+        GraphResource resource = unread.back();
+        unread.pop_back();
+        for (Pass& pass : this->passes)
+        {
+            if (pass.culled || pass.sideEffect)
+                continue;
+            bool writes = false;
+            for (GraphResource write : pass.writes)
+                if (write == resource) writes = true;
+            if (!writes || --pass.references > 0)
+                continue;
+
+            pass.culled = true;
+            for (GraphResource read : pass.reads)
+                if (--this->resources[read].readers == 0 && !this->resources[read].imported) unread.push_back(read);
+        }
+    }
+}
+
+void Core::RenderGraph::Place()
+{
+    for (Resource& resource : this->resources)
+    {
+        resource.firstPass = resource.lastPass = -1;
+        resource.physical = -1;
+    }
+    for (int p = 0; p < (int)this->passes.size(); p++)
+    {
+        if (this->passes[p].culled)
+            continue;
+        auto touch = [&](GraphResource r) {
+            Resource& resource = this->resources[r];
+            if (resource.firstPass < 0) resource.firstPass = p;
+            resource.lastPass = p;
+        };
+        for (GraphResource read : this->passes[p].reads) touch(read);
+        for (GraphResource write : this->passes[p].writes) touch(write);
+    }
+
+    for (PhysicalTexture& texture : this->pool)
+        texture.inUse = false;
+
+    // A texture is taken at the first pass of a resource and given back after its last,
+    // so what a pass reads and what it writes never share a texture.
+    for (int p = 0; p < (int)this->passes.size(); p++)
+    {
+        for (Resource& resource : this->resources)
+        {
+            if (!resource.imported && resource.firstPass == p)
+                resource.physical = this->Acquire(resource.desc);
+        }
+        for (Resource& resource : this->resources)
+        {
+            if (!resource.imported && resource.lastPass == p)
+                this->pool[resource.physical].inUse = false;
+        }
+    }
+}
+
+int Core::RenderGraph::Acquire(const GraphTextureDesc& desc)
+{
+    for (int i = 0; i < (int)this->pool.size(); i++)
+    {
+        PhysicalTexture& texture = this->pool[i];
+        if (!texture.inUse && SameDesc(texture.desc, desc))
+        {
+            texture.inUse = true;
+            texture.lastFrame = this->frame;
+            return i;
+        }
+    }
+
+    PhysicalTexture texture;
+    texture.texture = Core::CreateTargetTexture(desc.format, desc.width, desc.height);
+    texture.desc = desc;
+    texture.inUse = true;
+    texture.lastFrame = this->frame;
+    this->pool.push_back(texture);
+    return (int)this->pool.size() - 1;
+}
+
+void Core::RenderGraph::BindTargets(const Pass& pass)
+{
+    if (pass.writes.empty())
+        return;
+
+    const GraphTextureDesc& size = this->resources[pass.writes[0]].desc;
+    if (this->resources[pass.writes[0]].imported)
+    {
+        Core::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, size.width, size.height);
+        return;
+    }
+
+    std::vector<GLuint> key;
+    GLuint depth = 0;
+    for (GraphResource write : pass.writes)
+    {
+        const Resource& resource = this->resources[write];
+        GLuint texture = this->pool[resource.physical].texture;
+        if (IsDepthFormat(resource.desc.format)) depth = texture;
+        else key.push_back(texture);
+    }
+    size_t colorCount = key.size();
+    key.push_back(0);
+    key.push_back(depth);
+
+    auto found = this->framebuffers.find(key);
+    GLuint framebuffer;
+    if (found != this->framebuffers.end())
+    {
+        framebuffer = found->second;
+        Core::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+    else
+    {
+        glGenFramebuffers(1, &framebuffer);
+        Core::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (size_t i = 0; i < colorCount; i++)
+        {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, key[i], 0);
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+        }
+        if (depth != 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer of pass " << pass.name << " not complete!" << std::endl;
+        this->framebuffers[key] = framebuffer;
+    }
+    glViewport(0, 0, size.width, size.height);
+}
+
+void Core::RenderGraph::ReleaseUnused()
+{
+    bool released = false;
+    for (size_t i = 0; i < this->pool.size();)
+    {
+        if (this->frame - this->pool[i].lastFrame <= POOL_KEEP_FRAMES)
+        {
+            i++;
+            continue;
+        }
+        GLuint texture = this->pool[i].texture;
+        for (auto it = this->framebuffers.begin(); it != this->framebuffers.end();)
+        {
+            bool attached = false;
+            for (GLuint attachment : it->first)
+                if (attachment == texture) attached = true;
+            if (attached)
+            {
+                Core::BindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDeleteFramebuffers(1, &it->second);
+                it = this->framebuffers.erase(it);
+            }
+            else ++it;
+        }
+        glDeleteTextures(1, &texture);
+        this->pool.erase(this->pool.begin() + i);
+        released = true;
+    }
+    // the textures may still be shadowed on sampler units
+    if (released)
+        Core::InvalidateRenderState();
+}
+
+void Core::RenderGraph::Execute()
+{
+    this->Cull();
+    this->Place();
+
+    for (const Pass& pass : this->passes)
+    {
+        if (pass.culled)
+            continue;
+        if (this->beginHook) this->beginHook(pass.name.c_str());
+        this->BindTargets(pass);
+        if (pass.execute) pass.execute(*this);
+        if (this->endHook) this->endHook(pass.name.c_str());
+    }
+
+    this->stats = RenderGraphStats();
+    std::vector<bool> physicalUsed(this->pool.size(), false);
+    for (const Pass& pass : this->passes)
+        (pass.culled ? this->stats.passesCulled : this->stats.passes)++;
+    for (const Resource& resource : this->resources)
+    {
+        if (resource.imported || resource.physical < 0)
+            continue;
+        this->stats.textures++;
+        this->stats.textureBytes += DescBytes(resource.desc);
+        if (!physicalUsed[resource.physical])
+        {
+            physicalUsed[resource.physical] = true;
+            this->stats.physicalTextures++;
+            this->stats.physicalBytes += DescBytes(resource.desc);
+        }
+    }
+
+    if (this->reportRequested)
+    {
+        this->Report();
+        this->reportRequested = false;
+    }
+
+    this->frame++;
+    this->ReleaseUnused();
+    for (const PhysicalTexture& texture : this->pool)
+        this->stats.pooledBytes += DescBytes(texture.desc);
+
+    this->passes.clear();
+    this->resources.clear();
+}
+
+GLuint Core::RenderGraph::GetTexture(GraphResource resource) const
+{
+    const Resource& entry = this->resources[resource];
+    return entry.physical >= 0 ? this->pool[entry.physical].texture : 0;
+}
+
+const Core::GraphTextureDesc& Core::RenderGraph::GetDesc(GraphResource resource) const
+{
+    return this->resources[resource].desc;
+}
+
+void Core::RenderGraph::SetPassHooks(std::function<void(const char*)> begin, std::function<void(const char*)> end)
+{
+    this->beginHook = begin;
+    this->endHook = end;
+}
+
+void Core::RenderGraph::RequestReport()
+{
+    this->reportRequested = true;
+}
+
+const Core::RenderGraphStats& Core::RenderGraph::GetStats() const
+{
+    return this->stats;
+}
+
+void Core::RenderGraph::Report() const
+{
+    std::cout << "render graph: " << this->stats.passes << " passes (culled " << this->stats.passesCulled << ")" << std::endl;
+    for (const Pass& pass : this->passes)
+    {
+        if (pass.culled)
+            continue;
+        std::cout << "  " << pass.name << ":";
+        for (GraphResource read : pass.reads)
+            std::cout << " <" << this->resources[read].name;
+        for (GraphResource write : pass.writes)
+            std::cout << " >" << this->resources[write].name;
+        std::cout << std::endl;
+    }
+    std::cout << "render targets:" << std::endl;
+    for (const Resource& resource : this->resources)
+    {
+        if (resource.imported || resource.physical < 0)
+            continue;
+        std::cout << "  " << resource.name << " " << resource.desc.width << "x" << resource.desc.height << " " << resource.desc.format.name
+            << ": " << DescBytes(resource.desc) / (1024.f * 1024.f) << " MB, passes " << resource.firstPass << "-" << resource.lastPass
+            << " in texture " << resource.physical << std::endl;
+    }
+    std::cout << "  " << this->stats.textures << " transients (" << this->stats.textureBytes / (1024.f * 1024.f) << " MB) in "
+        << this->stats.physicalTextures << " textures (" << this->stats.physicalBytes / (1024.f * 1024.f) << " MB)" << std::endl;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "glew.h"
+#include "Render_Targets.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+	// Handle of a texture declared in a RenderGraph, valid for the frame it was declared in.
+	typedef int GraphResource;
+
+	struct GraphTextureDesc
+	{
+		int width;
+		int height;
+		TargetFormat format;
+	};
+
+	struct RenderGraphStats
+	{
+		int passes = 0;
+		int passesCulled = 0;
+		// transient textures used by the passes that ran
+		int textures = 0;
+		// GL textures they were placed in
+		int physicalTextures = 0;
+		// what the transients would take with a texture each, and what they took
+		size_t textureBytes = 0;
+		size_t physicalBytes = 0;
+		// everything the pool holds, including textures kept for other sizes and formats
+		size_t pooledBytes = 0;
+	};
+
+	class RenderGraph;
+
+	// Declares the reads and writes of one pass; returned by RenderGraph::AddPass.
+	class RenderPassBuilder
+	{
+	public:
+		RenderPassBuilder(RenderGraph* graph, int pass);
+		// New transient texture written by this pass; its contents start undefined.
+		GraphResource Create(const std::string& name, const GraphTextureDesc& desc);
+		GraphResource Read(GraphResource resource);
+		// Draws into a texture an earlier pass wrote, keeping its contents.
+		GraphResource Write(GraphResource resource);
+		// The pass runs even when nothing reads what it writes.
+		RenderPassBuilder& SideEffect();
+		void Execute(std::function<void(const RenderGraph&)> execute);
+
+	private:
+		RenderGraph* graph;
+		int pass;
+	};
+
+	// Frame described as passes with declared reads and writes, rebuilt every frame.
+	// Passes whose results nothing reads are culled. Transient textures live from the first
+	// to the last pass that uses them, and textures with the same size and format whose
+	// lifetimes do not overlap share one GL texture from a pool kept across frames.
+	// Before a pass runs, the graph binds a framebuffer with everything it writes and sets
+	// the viewport to the size of its first target.
+	class RenderGraph
+	{
+	public:
+		RenderGraph();
+		void Destroy();
+
+		RenderPassBuilder AddPass(const std::string& name);
+		// The default framebuffer; passes that write it always run.
+		GraphResource ImportBackbuffer(int width, int height);
+
+		// Culls, places the transients and runs the remaining passes in declaration order,
+		// then drops the declarations.
+		void Execute();
+
+		// GL texture of a resource; valid inside the execute function of a pass using it.
+		GLuint GetTexture(GraphResource resource) const;
+		const GraphTextureDesc& GetDesc(GraphResource resource) const;
+
+		// Called around every pass that runs, with its name; for profilers and debug groups.
+		void SetPassHooks(std::function<void(const char*)> begin, std::function<void(const char*)> end);
+		// Prints passes, lifetimes and placements of the next frame that executes.
+		void RequestReport();
+		const RenderGraphStats& GetStats() const;
+
+	private:
+		friend class RenderPassBuilder;
+
+		struct Resource
+		{
+			std::string name;
+			GraphTextureDesc desc;
+			bool imported;
+			int readers;
+			int firstPass;
+			int lastPass;
+			int physical;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<GraphResource> reads;
+			std::vector<GraphResource> writes;
+			bool sideEffect;
+			bool culled;
+			int references;
+			std::function<void(const RenderGraph&)> execute;
+		};
+
+		struct PhysicalTexture
+		{
+			GLuint texture;
+			GraphTextureDesc desc;
+			bool inUse;
+			int lastFrame;
+		};
+
+		void Cull();
+		void Place();
+		int Acquire(const GraphTextureDesc& desc);
+		void BindTargets(const Pass& pass);
+		void ReleaseUnused();
+		void Report() const;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<PhysicalTexture> pool;
+		// framebuffer of each set of attachments: color textures, then 0 and the depth texture
+		std::map<std::vector<GLuint>, GLuint> framebuffers;
+		std::function<void(const char*)> beginHook;
+		std::function<void(const char*)> endHook;
+		RenderGraphStats stats;
+		int frame;
+		bool reportRequested;
+	};
+}
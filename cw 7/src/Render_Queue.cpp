@@ -0,0 +1,278 @@
+#include "Render_Queue.h"
+#include "Render_State.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+uint64_t Core::MakeSortKey(unsigned pass, unsigned program, unsigned material, unsigned mesh, float depth)
+{
+    const float maxDepth = 10000.f;
+    float normalizedDepth = glm::clamp(depth / maxDepth, 0.f, 1.f);
+    uint64_t depthBits = (uint64_t)(normalizedDepth * 0xFFFFFF);
+
+    return ((uint64_t)(pass & 0xF) << 60) |
+        ((uint64_t)(program & 0xFF) << 52) |
+        ((uint64_t)(material & 0xFFFF) << 36) |
+        ((uint64_t)(mesh & 0xFFF) << 24) |
+        depthBits;
+}
+
+Core::RenderQueue::RenderQueue() : commandBuffer(0), instanceBuffer(0), commandCapacity(0), instanceCapacity(0) {}
+
+void Core::RenderQueue::Init()
+{
+    glGenBuffers(1, &this->commandBuffer);
+    glGenBuffers(1, &this->instanceBuffer);
+}
+
+void Core::RenderQueue::Destroy()
+{
+    glDeleteBuffers(1, &this->commandBuffer);
+    glDeleteBuffers(1, &this->instanceBuffer);
+    this->commandBuffer = 0;
+    this->instanceBuffer = 0;
+    this->commandCapacity = 0;
+    this->instanceCapacity = 0;
+}
+
+void Core::RenderQueue::Submit(const DrawItem& item)
+{
+    this->items.push_back(item);
+}
+
+namespace
+{
+    // Grows the store when needed, otherwise orphans it so the upload does not wait for last frame's draws.
+    void UploadStream(GLenum target, GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size)
+    {
+        glBindBuffer(target, buffer);
+        if (size > capacity)
+        {
+            capacity = size;
+            glBufferData(target, size, data, GL_STREAM_DRAW);
+        }
+        else
+        {
+            glBufferData(target, capacity, NULL, GL_STREAM_DRAW);
+            glBufferSubData(target, 0, size, data);
+        }
+    }
+}
+
+int Core::RenderQueue::SelectLod(const RenderContext& context, const glm::mat4& modelMatrix, const CameraView& view, unsigned object)
+{
+    int level = 0;
+    if (context.lodCount > 1)
+    {
+        glm::vec3 center;
+        float radius;
+        TransformBoundingSphere(context, modelMatrix, center, radius);
+        float distance = glm::length(center - view.position);
+        // radius as a fraction of half the viewport height; inside the sphere counts as huge
+        float screenRadius = distance > radius ? radius * view.projectionScale / distance : 1e9f;
+
+        uint64_t key = ((uint64_t)context.firstIndex << 32) | object;
+        auto previous = this->lodHistory.find(key);
+        if (previous == this->lodHistory.end())
+        {
+            while (level < context.lodCount - 1 && screenRadius < LOD_SCREEN_RADII[level])
+                level++;
+        }
+        else
+        {
+            // a level only changes once the radius is clearly past the threshold, so objects
+            // sitting on a threshold do not flicker between two levels
+            level = std::min(previous->second, context.lodCount - 1);
+            while (level > 0 && screenRadius > LOD_SCREEN_RADII[level - 1] * (1.f + LOD_HYSTERESIS))
+                level--;
+            while (level < context.lodCount - 1 && screenRadius < LOD_SCREEN_RADII[level] * (1.f - LOD_HYSTERESIS))
+                level++;
+        }
+        this->nextLodHistory[key] = level;
+    }
+
+    this->stats.lodObjects[level]++;
+    this->stats.triangles += context.lods[level].size / 3;
+    this->stats.fullDetailTriangles += context.size / 3;
+    return level;
+}
+
+void Core::RenderQueue::Flush(const MaterialLibrary& materials, const CameraView& view, JobSystem& jobs)
+{
+    this->stats = RenderQueueStats();
+    this->stats.items = (int)this->items.size();
+
+    this->order.clear();
+    for (int i = 0; i < (int)this->items.size(); i++)
+        this->order.push_back(std::make_pair(this->items[i].key, i));
+    // the index keeps submission order for equal keys
+    std::sort(this->order.begin(), this->order.end());
+
+    // Objects are numbered per mesh in submission order; the number keys their LOD history.
+    this->firstObjects.resize(this->items.size());
+    std::unordered_map<const RenderContext*, unsigned> objectCounts;
+    for (size_t i = 0; i < this->items.size(); i++)
+    {
+        unsigned& count = objectCounts[this->items[i].context];
+        this->firstObjects[i] = count;
+        count += this->items[i].instances != nullptr ? (unsigned)this->items[i].instances->size() : 1;
+    }
+
+    // Culls every object and picks its level. A multi-draw item gets one command per level
+    // in use, in draw order, with the instances of that level at baseInstance.
+    this->commands.clear();
+    this->instanceData.clear();
+    this->itemLods.assign(this->items.size(), -1);
+    this->itemCommands.assign(this->items.size(), 0);
+    this->nextLodHistory.clear();
+    for (const auto& entry : this->order)
+    {
+        const DrawItem& item = this->items[entry.second];
+        unsigned firstObject = this->firstObjects[entry.second];
+        if (!item.program->multiDraw)
+        {
+            if (IsVisible(view.frustum, *item.context, item.modelMatrix))
+            {
+                this->itemLods[entry.second] = this->SelectLod(*item.context, item.modelMatrix, view, firstObject);
+                this->stats.objectsDrawn++;
+            }
+            else this->stats.objectsCulled++;
+            continue;
+        }
+
+        for (int level = 0; level < MAX_MESH_LODS; level++)
+            this->lodInstances[level].clear();
+        InstanceData instance = {};
+        instance.material = item.material;
+        int total = item.instances != nullptr ? (int)item.instances->size() : 1;
+        // the frustum tests are independent; LOD selection below updates the history and stays serial
+        this->instanceVisible.resize(total);
+        jobs.ParallelFor(total, CULL_JOB_INSTANCES, [this, &item, &view](int begin, int end) {
+            for (int i = begin; i < end; i++)
+            {
+                const glm::mat4& modelMatrix = item.instances != nullptr ? (*item.instances)[i] : item.modelMatrix;
+                this->instanceVisible[i] = IsVisible(view.frustum, *item.context, modelMatrix);
+            }
+        });
+        for (int i = 0; i < total; i++)
+        {
+            instance.modelMatrix = item.instances != nullptr ? (*item.instances)[i] : item.modelMatrix;
+            if (!this->instanceVisible[i])
+            {
+                this->stats.objectsCulled++;
+                continue;
+            }
+            int level = this->SelectLod(*item.context, instance.modelMatrix, view, firstObject + i);
+            this->lodInstances[level].push_back(instance);
+            this->stats.objectsDrawn++;
+        }
+
+        for (int level = 0; level < MAX_MESH_LODS; level++)
+        {
+            if (this->lodInstances[level].empty())
+                continue;
+            DrawElementsIndirectCommand command;
+            command.count = item.context->lods[level].size;
+            command.instanceCount = (GLuint)this->lodInstances[level].size();
+            command.firstIndex = item.context->lods[level].firstIndex;
+            command.baseVertex = item.context->baseVertex;
+            command.baseInstance = (GLuint)this->instanceData.size();
+            this->commands.push_back(command);
+            this->instanceData.insert(this->instanceData.end(), this->lodInstances[level].begin(), this->lodInstances[level].end());
+            this->itemCommands[entry.second]++;
+        }
+    }
+    // entries of objects that were culled or gone this frame are dropped
+    this->lodHistory.swap(this->nextLodHistory);
+    if (!this->commands.empty())
+    {
+        UploadStream(GL_ARRAY_BUFFER, this->instanceBuffer, this->instanceCapacity, this->instanceData.data(), this->instanceData.size() * sizeof(InstanceData));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // stays bound, nothing else uses the indirect target
+        UploadStream(GL_DRAW_INDIRECT_BUFFER, this->commandBuffer, this->commandCapacity, this->commands.data(), this->commands.size() * sizeof(DrawElementsIndirectCommand));
+    }
+    this->stats.multiDrawCommands = (int)this->commands.size();
+    this->stats.instances = (int)this->instanceData.size();
+
+    // nothing is known about the bindings left by earlier passes
+    const GLuint unknown = ~0u;
+    GLuint currentProgram = unknown;
+    GLuint currentVertexArray = unknown;
+    int currentMaterial = -1;
+    int nextCommand = 0;
+
+    auto isSkipped = [this](int index) {
+        return this->items[index].program->multiDraw ? this->itemCommands[index] == 0 : this->itemLods[index] < 0;
+    };
+
+    for (size_t k = 0; k < this->order.size(); k++)
+    {
+        DrawItem& item = this->items[this->order[k].second];
+        const DrawProgram& program = *item.program;
+        if (isSkipped(this->order[k].second))
+            continue;
+
+        if (program.id != currentProgram)
+        {
+            Core::UseProgram(program.id);
+            currentProgram = program.id;
+            this->stats.programBinds++;
+
+            // the index uniform belongs to the program, its last value is not tracked
+            currentMaterial = -1;
+            if (program.materialMaps.unit >= 0)
+                Core::BindTextureUnit(program.materialMaps.unit, GL_TEXTURE_2D_ARRAY, materials.GetTextureArray());
+        }
+        else this->stats.programBindsSkipped++;
+
+        if (item.context->vertexArray != currentVertexArray)
+        {
+            Core::BindVertexArray(item.context->vertexArray);
+            currentVertexArray = item.context->vertexArray;
+            this->stats.vertexArrayBinds++;
+            glBindVertexBuffer(INSTANCE_BUFFER_BINDING, this->instanceBuffer, 0, sizeof(InstanceData));
+        }
+        else this->stats.vertexArrayBindsSkipped++;
+
+        if (program.multiDraw)
+        {
+            // extend the run over every following item that shares program and vertex array
+            int first = nextCommand;
+            int count = this->itemCommands[this->order[k].second];
+            while (k + 1 < this->order.size())
+            {
+                const DrawItem& next = this->items[this->order[k + 1].second];
+                bool nextSkipped = isSkipped(this->order[k + 1].second);
+                if (!nextSkipped && (next.program != item.program || next.context->vertexArray != item.context->vertexArray))
+                    break;
+                count += this->itemCommands[this->order[k + 1].second];
+                k++;
+            }
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(sizeof(DrawElementsIndirectCommand) * first), count, 0);
+            nextCommand += count;
+            this->stats.drawCalls++;
+            continue;
+        }
+
+        if (item.material != currentMaterial)
+        {
+            glUniform1i(program.materialIndex.location, item.material);
+            currentMaterial = item.material;
+            this->stats.materialSwitches++;
+        }
+        else this->stats.materialSwitchesSkipped++;
+
+        glUniformMatrix4fv(program.modelMatrix.location, 1, GL_FALSE, (float*)&item.modelMatrix);
+        const MeshLod& lod = item.context->lods[this->itemLods[this->order[k].second]];
+        glDrawElementsBaseVertex(GL_TRIANGLES, lod.size, GL_UNSIGNED_INT,
+            (void*)(sizeof(GLuint) * lod.firstIndex), item.context->baseVertex);
+        this->stats.drawCalls++;
+    }
+
+    this->items.clear();
+}
+
+const Core::RenderQueueStats& Core::RenderQueue::GetStats() const
+{
+    return this->stats;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "glew.h"
+#include "glm.hpp"
+#include "Frustum.h"
+#include "Geometry_Arena.h"
+#include "Job_System.h"
+#include "Material_Library.h"
+#include "Render_Utils.h"
+#include "Shader_Loader.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Core
+{
+	enum RenderPass
+	{
+		PASS_OPAQUE = 0,
+		PASS_EMISSIVE = 1
+	};
+
+	// Program together with the handles the queue needs to draw with it.
+	// A multi-draw program reads the model matrix and material from the instance stream,
+	// so consecutive items using it are submitted with a single glMultiDrawElementsIndirect.
+	// Other programs are drawn one item at a time through the modelMatrix and materialIndex uniforms.
+	struct DrawProgram
+	{
+		GLuint id = 0;
+		bool multiDraw = false;
+		Uniform modelMatrix;
+		Uniform materialIndex;
+		Sampler materialMaps;
+	};
+
+	// Command layout read by glMultiDrawElementsIndirect.
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	struct DrawItem
+	{
+		uint64_t key = 0;
+		const DrawProgram* program = nullptr;
+		RenderContext* context = nullptr;
+		int material = 0;
+		glm::mat4 modelMatrix;
+		// when set, every matrix is one instance of the item and modelMatrix is ignored;
+		// only multi-draw programs can draw instances
+		const std::vector<glm::mat4>* instances = nullptr;
+	};
+
+	struct RenderQueueStats
+	{
+		int items = 0;
+		int programBinds = 0;
+		int programBindsSkipped = 0;
+		int vertexArrayBinds = 0;
+		int vertexArrayBindsSkipped = 0;
+		int materialSwitches = 0;
+		int materialSwitchesSkipped = 0;
+		int drawCalls = 0;
+		int multiDrawCommands = 0;
+		int instances = 0;
+		// objects are single items or single instances
+		int objectsDrawn = 0;
+		int objectsCulled = 0;
+		int lodObjects[MAX_MESH_LODS] = {};
+		int triangles = 0;
+		int fullDetailTriangles = 0;
+	};
+
+	// Screen radius (fraction of half the viewport height) below which a level gives way to the next.
+	const float LOD_SCREEN_RADII[MAX_MESH_LODS - 1] = { 0.25f, 0.1f, 0.04f };
+	// How far past a threshold the radius has to move before the level changes.
+	const float LOD_HYSTERESIS = 0.15f;
+	// Instances one culling job tests; smaller batches are tested on the calling thread.
+	const int CULL_JOB_INSTANCES = 256;
+
+	// Key layout, most significant first: pass 4 bits, program 8, material 16, mesh 12, depth 24.
+	// Depth only breaks ties between items that share all state, front to back.
+	uint64_t MakeSortKey(unsigned pass, unsigned program, unsigned material, unsigned mesh, float depth);
+
+	class RenderQueue
+	{
+	public:
+		RenderQueue();
+		void Init();
+		void Destroy();
+		void Submit(const DrawItem& item);
+		// Sorts the frame's items, draws them without redundant binds and empties the queue.
+		// All items sample the library's texture array, so only the material index changes between them.
+		// Items and instances outside the frustum are dropped before anything is uploaded,
+		// the rest are drawn with the level of detail that fits their size on screen.
+		// Large instance batches are culled in parallel on the job system.
+		void Flush(const MaterialLibrary& materials, const CameraView& view, JobSystem& jobs);
+		const RenderQueueStats& GetStats() const;
+
+	private:
+		int SelectLod(const RenderContext& context, const glm::mat4& modelMatrix, const CameraView& view, unsigned object);
+
+		std::vector<DrawItem> items;
+		std::vector<std::pair<uint64_t, int>> order;
+		std::vector<unsigned> firstObjects;
+		// per item: level of a single draw (-1 when culled), number of commands of a multi-draw
+		std::vector<int> itemLods;
+		std::vector<int> itemCommands;
+		std::vector<InstanceData> lodInstances[MAX_MESH_LODS];
+		// frustum test result of each instance of the item being flushed
+		std::vector<char> instanceVisible;
+		// last level of each object, keyed by mesh and object number
+		std::unordered_map<uint64_t, int> lodHistory;
+		std::unordered_map<uint64_t, int> nextLodHistory;
+		std::vector<DrawElementsIndirectCommand> commands;
+		std::vector<InstanceData> instanceData;
+		GLuint commandBuffer;
+		GLuint instanceBuffer;
+		GLsizeiptr commandCapacity;
+		GLsizeiptr instanceCapacity;
+		RenderQueueStats stats;
+	};
+}
@@ -1,9 +1,10 @@
 #include <iostream>
 #include "Render_Sprite.h"
+#include "Render_State.h"
 #include <ext.hpp>
 #include <GLFW/glfw3.h>
 
-Core::RenderSprite::RenderSprite() {
+Core::RenderSprite::RenderSprite() : currentTextureID(0), program(0) {
     this->initSprite();
 }
 
@@ -12,7 +13,14 @@ Core::RenderSprite::~RenderSprite() {
     glDeleteBuffers(1, &this->VBO);
 }
 
-void Core::RenderSprite::DrawSprite(GLuint program, float spriteWidth, float spriteHeight) {
+void Core::RenderSprite::SetProgram(const Shader_Loader& loader, GLuint program) {
+    this->program = program;
+    this->projection = loader.GetUniform(program, "projection");
+    this->model = loader.GetUniform(program, "model");
+    this->spriteTexture = loader.GetSampler(program, "spriteTexture");
+}
+
+void Core::RenderSprite::DrawSprite(float spriteWidth, float spriteHeight) {
     GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
     const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
     float screenWidth = mode->width;
@@ -23,19 +31,16 @@ void Core::RenderSprite::DrawSprite(GLuint program, float spriteWidth, float spr
     model = glm::translate(model, glm::vec3((screenWidth - spriteWidth) / 2.0f, (screenHeight - spriteHeight) / 2.0f, 0.0f));
     model = glm::scale(model, glm::vec3(glm::vec2(spriteWidth, spriteHeight), 1.0f));
 
-    glUseProgram(program);
+    Core::UseProgram(this->program);
 
-    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, (float*)&projection);
-    glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, (float*)&model);
+    glUniformMatrix4fv(this->projection.location, 1, GL_FALSE, (float*)&projection);
+    glUniformMatrix4fv(this->model.location, 1, GL_FALSE, (float*)&model);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, this->currentTextureID);
-    GLuint textureLocation = glGetUniformLocation(program, "spriteTexture");
-    glUniform1i(textureLocation, 0);
+    // the sampler was pointed at its unit when the program was linked
+    Core::BindTextureUnit(this->spriteTexture.unit, GL_TEXTURE_2D, this->currentTextureID);
 
-    glBindVertexArray(this->VAO);
+    Core::BindVertexArray(this->VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 }
 
 void Core::RenderSprite::initSprite() {
@@ -52,16 +57,14 @@ void Core::RenderSprite::initSprite() {
     glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
 
-    glBindVertexArray(this->VAO);
+    Core::BindVertexArray(this->VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->VAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
 
 void Core::RenderSprite::UpdateSprite(GLuint newTextureID) {
@@ -1,6 +1,7 @@
 #pragma once
 #include "Render_Utils.h"
 #include "Texture.h"
+#include "Shader_Loader.h"
 
 
 namespace Core {
@@ -9,7 +10,9 @@ namespace Core {
     public:
         RenderSprite();
         ~RenderSprite();
-        void DrawSprite(GLuint program, float width, float height);
+        // Takes the program's locations from the loader once, not on every draw.
+        void SetProgram(const Shader_Loader& loader, GLuint program);
+        void DrawSprite(float width, float height);
         void UpdateSprite(GLuint newTextureID);
 
     private:
@@ -17,6 +20,10 @@ namespace Core {
         unsigned int VAO;
         unsigned int VBO;
         GLuint currentTextureID;
+        GLuint program;
+        Uniform projection;
+        Uniform model;
+        Sampler spriteTexture;
         void initSprite();
     };
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "Render_State.h"
+
+#include <algorithm>
+#include <map>
+
+namespace
+{
+	const GLuint UNKNOWN = ~0u;
+	const int MAX_TEXTURE_UNITS = 32;
+
+	enum TextureTargetIndex
+	{
+		TARGET_2D = 0,
+		TARGET_2D_ARRAY,
+		TARGET_CUBE_MAP,
+		TARGET_COUNT
+	};
+
+	struct ShadowState
+	{
+		GLuint program = UNKNOWN;
+		GLuint vertexArray = UNKNOWN;
+		GLuint activeUnit = UNKNOWN;
+		GLuint textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+		GLuint readFramebuffer = UNKNOWN;
+		GLuint drawFramebuffer = UNKNOWN;
+		std::map<GLenum, bool> capabilities;
+
+		ShadowState()
+		{
+			std::fill(&textures[0][0], &textures[0][0] + MAX_TEXTURE_UNITS * TARGET_COUNT, UNKNOWN);
+		}
+	};
+
+	ShadowState shadow;
+	Core::RenderStateCounters counters;
+
+	int TargetIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D: return TARGET_2D;
+		case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+		case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+		default: return -1;
+		}
+	}
+
+	void SetCapability(GLenum capability, bool enabled)
+	{
+		auto it = shadow.capabilities.find(capability);
+		if (it != shadow.capabilities.end() && it->second == enabled)
+		{
+			counters.filtered[Core::STATE_CAPABILITY]++;
+			return;
+		}
+		if (enabled) glEnable(capability); else glDisable(capability);
+		shadow.capabilities[capability] = enabled;
+		counters.issued[Core::STATE_CAPABILITY]++;
+	}
+}
+
+int Core::RenderStateCounters::TotalIssued() const
+{
+	int total = 0;
+	for (int i = 0; i < STATE_CALL_COUNT; i++) total += issued[i];
+	return total;
+}
+
+int Core::RenderStateCounters::TotalFiltered() const
+{
+	int total = 0;
+	for (int i = 0; i < STATE_CALL_COUNT; i++) total += filtered[i];
+	return total;
+}
+
+void Core::UseProgram(GLuint program)
+{
+	if (shadow.program == program)
+	{
+		counters.filtered[STATE_PROGRAM]++;
+		return;
+	}
+	glUseProgram(program);
+	shadow.program = program;
+	counters.issued[STATE_PROGRAM]++;
+}
+
+void Core::BindVertexArray(GLuint vertexArray)
+{
+	if (shadow.vertexArray == vertexArray)
+	{
+		counters.filtered[STATE_VERTEX_ARRAY]++;
+		return;
+	}
+	glBindVertexArray(vertexArray);
+	shadow.vertexArray = vertexArray;
+	counters.issued[STATE_VERTEX_ARRAY]++;
+}
+
+void Core::ActiveTexture(GLenum textureUnit)
+{
+	GLuint unit = textureUnit - GL_TEXTURE0;
+	if (shadow.activeUnit == unit)
+	{
+		counters.filtered[STATE_ACTIVE_TEXTURE]++;
+		return;
+	}
+	glActiveTexture(textureUnit);
+	shadow.activeUnit = unit;
+	counters.issued[STATE_ACTIVE_TEXTURE]++;
+}
+
+void Core::BindTexture(GLenum target, GLuint texture)
+{
+	int targetIndex = TargetIndex(target);
+	GLuint unit = shadow.activeUnit;
+	bool tracked = targetIndex >= 0 && unit < MAX_TEXTURE_UNITS;
+	if (tracked && shadow.textures[unit][targetIndex] == texture)
+	{
+		counters.filtered[STATE_TEXTURE]++;
+		return;
+	}
+	glBindTexture(target, texture);
+	if (tracked)
+		shadow.textures[unit][targetIndex] = texture;
+	counters.issued[STATE_TEXTURE]++;
+}
+
+void Core::BindTextureUnit(GLuint unit, GLenum target, GLuint texture)
+{
+	// unit -1 is a sampler the program does not use
+	if (unit == (GLuint)-1)
+		return;
+	int targetIndex = TargetIndex(target);
+	if (targetIndex >= 0 && unit < MAX_TEXTURE_UNITS && shadow.textures[unit][targetIndex] == texture)
+	{
+		counters.filtered[STATE_TEXTURE]++;
+		return;
+	}
+	Core::ActiveTexture(GL_TEXTURE0 + unit);
+	Core::BindTexture(target, texture);
+}
+
+void Core::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+	bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+	if ((!read || shadow.readFramebuffer == framebuffer) && (!draw || shadow.drawFramebuffer == framebuffer))
+	{
+		counters.filtered[STATE_FRAMEBUFFER]++;
+		return;
+	}
+	glBindFramebuffer(target, framebuffer);
+	if (read) shadow.readFramebuffer = framebuffer;
+	if (draw) shadow.drawFramebuffer = framebuffer;
+	counters.issued[STATE_FRAMEBUFFER]++;
+}
+
+void Core::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+void Core::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+void Core::InvalidateRenderState()
+{
+	shadow = ShadowState();
+}
+
+const Core::RenderStateCounters& Core::GetRenderStateCounters()
+{
+	return counters;
+}
+
+void Core::ResetRenderStateCounters()
+{
+	counters = RenderStateCounters();
+}
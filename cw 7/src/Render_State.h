@@ -0,0 +1,47 @@
+#pragma once
+
+#include "glew.h"
+
+namespace Core
+{
+	// Every bind and enable in the renderer goes through these functions. They shadow
+	// the bound state and drop calls that would not change it.
+
+	enum StateCall
+	{
+		STATE_PROGRAM = 0,
+		STATE_VERTEX_ARRAY,
+		STATE_ACTIVE_TEXTURE,
+		STATE_TEXTURE,
+		STATE_FRAMEBUFFER,
+		STATE_CAPABILITY,
+		STATE_CALL_COUNT
+	};
+
+	struct RenderStateCounters
+	{
+		int issued[STATE_CALL_COUNT] = {};
+		int filtered[STATE_CALL_COUNT] = {};
+
+		int TotalIssued() const;
+		int TotalFiltered() const;
+	};
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void ActiveTexture(GLenum textureUnit);
+	// Binds to the active unit, like glBindTexture.
+	void BindTexture(GLenum target, GLuint texture);
+	// Switches the active unit only when the texture is not bound there already. Unit -1,
+	// the unit of a sampler the program does not use, binds nothing.
+	void BindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+	void BindFramebuffer(GLenum target, GLuint framebuffer);
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+
+	// Forgets all shadowed state; call after deleting bound objects or after raw GL calls.
+	void InvalidateRenderState();
+
+	const RenderStateCounters& GetRenderStateCounters();
+	void ResetRenderStateCounters();
+}
@@ -0,0 +1,49 @@
+#include "Render_Targets.h"
+#include "Render_State.h"
+
+namespace
+{
+    const Core::RenderTargetFormats PROFILES[Core::TARGET_PROFILE_COUNT] = {
+        { "quality", Core::TARGET_RGBA16F, Core::TARGET_DEPTH32F, Core::TARGET_RGBA16F, 2 },
+        // the bloom chain never uses alpha, so it loses nothing visible in the packed format
+        { "balanced", Core::TARGET_RGBA16F, Core::TARGET_DEPTH24, Core::TARGET_R11F_G11F_B10F, 2 },
+        { "low", Core::TARGET_R11F_G11F_B10F, Core::TARGET_DEPTH24, Core::TARGET_R11F_G11F_B10F, 4 }
+    };
+}
+
+const Core::RenderTargetFormats& Core::GetRenderTargetFormats(RenderTargetProfile profile)
+{
+    return PROFILES[profile];
+}
+
+bool Core::ParseRenderTargetProfile(const std::string& name, RenderTargetProfile& profile)
+{
+    for (int i = 0; i < TARGET_PROFILE_COUNT; i++)
+    {
+        if (name == PROFILES[i].name)
+        {
+            profile = (RenderTargetProfile)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+GLuint Core::CreateTargetTexture(const TargetFormat& format, int width, int height)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    Core::BindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format.internalFormat, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // we clamp to the edge as the blur filters would otherwise sample repeated texture values
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+bool Core::IsDepthFormat(const TargetFormat& format)
+{
+    return format.internalFormat == GL_DEPTH_COMPONENT24 || format.internalFormat == GL_DEPTH_COMPONENT32F;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "glew.h"
+#include <string>
+
+namespace Core
+{
+	// Sized internal format of a render target and what one texel of it costs.
+	struct TargetFormat
+	{
+		GLenum internalFormat;
+		int bytesPerTexel;
+		bool hasAlpha;
+		const char* name;
+	};
+
+	const TargetFormat TARGET_RGBA16F = { GL_RGBA16F, 8, true, "RGBA16F" };
+	const TargetFormat TARGET_R11F_G11F_B10F = { GL_R11F_G11F_B10F, 4, false, "R11F_G11F_B10F" };
+	// 24-bit depth is stored padded to 32 bits
+	const TargetFormat TARGET_DEPTH24 = { GL_DEPTH_COMPONENT24, 4, false, "DEPTH24" };
+	const TargetFormat TARGET_DEPTH32F = { GL_DEPTH_COMPONENT32F, 4, false, "DEPTH32F" };
+
+	enum RenderTargetProfile
+	{
+		TARGET_PROFILE_QUALITY = 0,
+		TARGET_PROFILE_BALANCED,
+		TARGET_PROFILE_LOW_MEMORY,
+		TARGET_PROFILE_COUNT
+	};
+
+	// Formats and sizes of the HDR and bloom targets. Shaders sample every format the same
+	// way, so switching profiles needs no shader changes; only a scene format without alpha
+	// loses the per-pixel bloom threshold, and the bright pass then uses a global one.
+	struct RenderTargetFormats
+	{
+		const char* name;
+		TargetFormat sceneColor;
+		TargetFormat sceneDepth;
+		// bright buffer, Gaussian ping-pong buffers and pyramid levels
+		TargetFormat bloomColor;
+		// scene texels per bright buffer texel along each side: 2 is half size, 4 quarter size
+		int brightDownscale;
+	};
+
+	const RenderTargetFormats& GetRenderTargetFormats(RenderTargetProfile profile);
+	// Accepts "quality", "balanced" and "low"; returns false for anything else.
+	bool ParseRenderTargetProfile(const std::string& name, RenderTargetProfile& profile);
+
+	// Single-level 2D texture with linear filtering and clamped edges, color or depth.
+	GLuint CreateTargetTexture(const TargetFormat& format, int width, int height);
+	bool IsDepthFormat(const TargetFormat& format);
+}
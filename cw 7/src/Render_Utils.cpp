@@ -1,6 +1,10 @@
 #include "Render_Utils.h"
+#include "Cpu_Profiler.h"
+#include "Geometry_Arena.h"
+#include "Render_State.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 #include "glew.h"
 #include "freeglut.h"
@@ -11,82 +15,6 @@
 
 
 
-void Core::RenderContext::initFromAssimpMesh(aiMesh* mesh) {
-    vertexArray = 0;
-    vertexBuffer = 0;
-    vertexIndexBuffer = 0;
-
-    std::vector<float> textureCoord;
-    std::vector<unsigned int> indices;
-    //tex coord must be converted to 2d vecs
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-    {
-        if (mesh->mTextureCoords[0] != nullptr) {
-            textureCoord.push_back(mesh->mTextureCoords[0][i].x);
-            textureCoord.push_back(mesh->mTextureCoords[0][i].y);
-        }
-        else {
-            textureCoord.push_back(0.0f);
-            textureCoord.push_back(0.0f);
-        }
-    }
-    if (mesh->mTextureCoords[0] == nullptr) {
-        std::cout << "no uv coords\n";
-    }
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-    {
-        aiFace face = mesh->mFaces[i];
-        // retrieve all indices of the face and store them in the indices vector
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
-    }
-
-    unsigned int vertexDataBufferSize = sizeof(float) * mesh->mNumVertices * 3;
-    unsigned int vertexNormalBufferSize = sizeof(float) * mesh->mNumVertices * 3;
-    unsigned int vertexTexBufferSize = sizeof(float) * mesh->mNumVertices * 2;
-    unsigned int vertexTangentBufferSize = sizeof(float) * mesh->mNumVertices * 3;
-    unsigned int vertexBiTangentBufferSize = sizeof(float) * mesh->mNumVertices * 3;
-
-    unsigned int vertexElementBufferSize = sizeof(unsigned int) * indices.size();
-    size = indices.size();
-
-    glGenVertexArrays(1, &vertexArray);
-    glBindVertexArray(vertexArray);
-
-
-    glGenBuffers(1, &vertexIndexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertexIndexBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertexElementBufferSize, &indices[0], GL_STATIC_DRAW);
-
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    //std::cout << vertexBuffer;
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glEnableVertexAttribArray(3);
-    glEnableVertexAttribArray(4);
-
-    glBufferData(GL_ARRAY_BUFFER, vertexDataBufferSize + vertexNormalBufferSize + vertexTexBufferSize + vertexTangentBufferSize + vertexBiTangentBufferSize, NULL, GL_STATIC_DRAW);
-
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexDataBufferSize, mesh->mVertices);
-
-    glBufferSubData(GL_ARRAY_BUFFER, vertexDataBufferSize, vertexNormalBufferSize, mesh->mNormals);
-
-    glBufferSubData(GL_ARRAY_BUFFER, vertexDataBufferSize + vertexNormalBufferSize, vertexTexBufferSize, &textureCoord[0]);
-
-    glBufferSubData(GL_ARRAY_BUFFER, vertexDataBufferSize + vertexNormalBufferSize + vertexTexBufferSize, vertexTangentBufferSize, mesh->mTangents);
-
-    glBufferSubData(GL_ARRAY_BUFFER, vertexDataBufferSize + vertexNormalBufferSize + vertexTexBufferSize + vertexTangentBufferSize, vertexBiTangentBufferSize, mesh->mBitangents);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)(0));
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)(vertexDataBufferSize));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)(vertexNormalBufferSize + vertexDataBufferSize));
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (void*)(vertexDataBufferSize + vertexNormalBufferSize + vertexTexBufferSize));
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (void*)(vertexDataBufferSize + vertexNormalBufferSize + vertexTexBufferSize + vertexTangentBufferSize));
-
-}
-
 void Core::DrawVertexArray(const float * vertexArray, int numVertices, int elementSize )
 {
 	glVertexAttribPointer(0, elementSize, GL_FLOAT, false, 0, vertexArray);
@@ -118,31 +46,53 @@ void Core::DrawVertexArray( const VertexData & data )
 void Core::DrawContext(Core::RenderContext& context)
 {
 
-	glBindVertexArray(context.vertexArray);
-	glDrawElements(
+	Core::BindVertexArray(context.vertexArray);
+	glDrawElementsBaseVertex(
 		GL_TRIANGLES,
 		context.size,
 		GL_UNSIGNED_INT,
-		(void*)0
+		(void*)(sizeof(GLuint) * context.firstIndex),
+		context.baseVertex
 	);
-	glBindVertexArray(0);
 }
 
-void Core::DrawSkybox(GLuint program, Core::RenderContext& context, GLuint TextureID, glm::vec3 cameraDir, glm::vec3 cameraPos, float aspectRatio)
+void Core::DrawScreenQuad()
 {
-    glDisable(GL_DEPTH_TEST);
+    static GLuint quadVAO = 0;
+    static GLuint quadVBO = 0;
+    if (quadVAO == 0)
+    {
+        float quadVertices[] = {
+            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+        };
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        Core::BindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    }
+    Core::BindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
 
-    glUseProgram(program);
+void Core::DrawSkybox(GLuint program, Core::RenderContext& context, GLuint TextureID)
+{
+    Core::Disable(GL_DEPTH_TEST);
 
-    glm::mat4 viewMatrix = glm::mat4(glm::mat3(Core::createCameraMatrix(cameraDir, cameraPos)));
-    glm::mat4 skyboxTransformation = Core::createPerspectiveMatrix(aspectRatio) * viewMatrix;
-    glUniformMatrix4fv(glGetUniformLocation(program, "transformation"), 1, GL_FALSE, (float*)&skyboxTransformation);
+    Core::UseProgram(program);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, TextureID);
+    // the skybox sampler is the only one in its program, so it sits on unit 0
+    Core::BindTextureUnit(0, GL_TEXTURE_CUBE_MAP, TextureID);
     Core::DrawContext(context);
-    glUseProgram(0);
 
-    glEnable(GL_DEPTH_TEST);
+    Core::Enable(GL_DEPTH_TEST);
 }
 
 glm::mat4 Core::createCameraMatrix(glm::vec3 cameraDir, glm::vec3 cameraPos)
@@ -182,10 +132,13 @@ glm::mat4 Core::createPerspectiveMatrix(float aspectRatio)
     return perspectiveMatrix;
 }
 
-void Core::loadModelToContext(std::string path, Core::RenderContext& context)
+void Core::loadModelToContext(std::string path, Core::RenderContext& context, GeometryArena& arena)
 {
+    PROFILE_FUNCTION();
     Assimp::Importer import;
-    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_CalcTangentSpace);
+    // OBJ meshes come with a vertex per face corner; joined, only real uv and normal seams
+    // keep separate vertices, which the LOD chain needs to collapse anything
+    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
@@ -197,5 +150,5 @@ void Core::loadModelToContext(std::string path, Core::RenderContext& context)
         throw std::runtime_error("ERROR::ASSIMP::No meshes found in the model.");
     }
 
-    context.initFromAssimpMesh(scene->mMeshes[0]);
+    arena.Add(scene->mMeshes[0], context);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 #include "glm.hpp"
 #include "glew.h"
-#include "objload.h"
+#include <vector>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -10,16 +10,36 @@
 
 namespace Core
 {
+	class GeometryArena;
+
+	const int MAX_MESH_LODS = 4;
+
+	// Index range of one level of detail; all levels of a mesh share its vertices.
+	struct MeshLod
+	{
+		GLuint firstIndex = 0;
+		int size = 0;
+	};
+
+	// Range of one mesh inside the GeometryArena; every context shares the arena's vertex array.
+	// firstIndex and size are the full-detail range, the same as lods[0].
 	struct RenderContext
     {
-		GLuint vertexArray;
-		GLuint vertexBuffer;
-		GLuint vertexIndexBuffer;
+		GLuint vertexArray = 0;
+		// order of the mesh in the arena; the draw sort groups on it
+		int meshIndex = 0;
+		GLuint firstIndex = 0;
+		GLint baseVertex = 0;
 		int size = 0;
 
-        void initFromOBJ(obj::Model& model);
+		MeshLod lods[MAX_MESH_LODS];
+		int lodCount = 0;
 
-		void initFromAssimpMesh(aiMesh* mesh);
+		// mesh-space bounds, filled when the mesh is added to the arena
+		glm::vec3 boundsMin = glm::vec3(0.f);
+		glm::vec3 boundsMax = glm::vec3(0.f);
+		glm::vec3 sphereCenter = glm::vec3(0.f);
+		float sphereRadius = 0.f;
 	};
 
 	void DrawVertexArray(const float * vertexArray, int numVertices, int elementSize);
@@ -45,11 +65,16 @@ namespace Core
 
 	void DrawContext(RenderContext& context);
 
-	void DrawSkybox(GLuint program, Core::RenderContext& context, GLuint TextureID, glm::vec3 cameraDir, glm::vec3 cameraPos, float aspectRatio);
+	// Full-screen quad with positions in attribute 0 and texture coordinates in 1, for post passes.
+	void DrawScreenQuad();
+
+	// The view-projection without translation comes from the PerFrame block.
+	void DrawSkybox(GLuint program, Core::RenderContext& context, GLuint TextureID);
 
 	glm::mat4 createCameraMatrix(glm::vec3 cameraDir, glm::vec3 cameraPos);
 
 	glm::mat4 createPerspectiveMatrix(float aspectRatio);
 
-	void loadModelToContext(std::string path, Core::RenderContext& context);
+	// Loads the first mesh of the file into the arena and points the context at it.
+	void loadModelToContext(std::string path, Core::RenderContext& context, GeometryArena& arena);
 }
\ No newline at end of file
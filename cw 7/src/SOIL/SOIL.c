@@ -39,7 +39,8 @@
 #include <string.h>
 
 /*	error reporting	*/
-char *result_string_pointer = "SOIL initialized";
+/*	kept per thread, see STBI_THREAD_LOCAL	*/
+STBI_THREAD_LOCAL char *result_string_pointer = "SOIL initialized";
 
 /*	for loading cube maps	*/
 enum{
@@ -160,6 +160,18 @@
 
 #define STBI_VERSION 1
 
+// Storage of the failure strings. Images are decoded on several threads at once, so each
+// thread keeps its own and reads back the reason of its own failure.
+#ifndef STBI_THREAD_LOCAL
+   #if defined(_MSC_VER)
+      #define STBI_THREAD_LOCAL __declspec(thread)
+   #elif defined(__GNUC__) || defined(__clang__)
+      #define STBI_THREAD_LOCAL __thread
+   #else
+      #define STBI_THREAD_LOCAL _Thread_local
+   #endif
+#endif
+
 enum
 {
    STBI_default = 0, // only used for req_comp
@@ -213,7 +225,7 @@ extern void   stbi_ldr_to_hdr_scale(float scale);
 #endif // STBI_NO_HDR
 
 // get a VERY brief reason for failure
-// NOT THREADSAFE
+// of the last failure on the calling thread
 extern char    *stbi_failure_reason  (void); 
 
 // free the loaded image -- this is just free()
@@ -1,4 +1,6 @@
 #include "Shader_Loader.h" 
+#include "Cpu_Profiler.h"
+#include "Render_State.h"
 #include<iostream>
 #include<fstream>
 #include<vector>
@@ -60,6 +62,7 @@ GLuint Shader_Loader::CreateShader(GLenum shaderType, std::string
 GLuint Shader_Loader::CreateProgram(char* vertexShaderFilename,
 	char* fragmentShaderFilename)
 {
+	PROFILE_FUNCTION();
 
 	//wczytaj shadery
 	std::string vertex_shader_code = ReadShader(vertexShaderFilename);
@@ -93,10 +96,103 @@ GLuint Shader_Loader::CreateProgram(char* vertexShaderFilename,
 	glDeleteShader(vertex_shader);
 	glDeleteShader(fragment_shader);
 
+	ReflectProgram(program);
+
 	return program;
 }
 
+static bool IsSamplerType(GLenum type)
+{
+	switch (type)
+	{
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_2D_MULTISAMPLE:
+	case GL_INT_SAMPLER_2D:
+	case GL_UNSIGNED_INT_SAMPLER_2D:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Shader_Loader::ReflectProgram(GLuint program)
+{
+	ProgramReflection& reflection = reflections[program];
+	reflection = ProgramReflection();
+
+	int uniformCount = 0;
+	int maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength + 1);
+
+	// sampler units are bound once here instead of on every draw
+	Core::UseProgram(program);
+	GLint nextUnit = 0;
+	for (int i = 0; i < uniformCount; i++)
+	{
+		GLint arraySize = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+		glGetActiveUniform(program, i, (GLsizei)nameBuffer.size(), &length, &arraySize, &type, &nameBuffer[0]);
+
+		std::string name(&nameBuffer[0], length);
+		// arrays are reported as "name[0]"
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			name.resize(name.size() - 3);
+
+		// uniforms living in a block have no location
+		GLint location = glGetUniformLocation(program, name.c_str());
+		if (location < 0)
+			continue;
+		reflection.uniformLocations[name] = location;
+
+		if (IsSamplerType(type))
+		{
+			std::vector<GLint> units(arraySize);
+			for (GLint j = 0; j < arraySize; j++)
+				units[j] = nextUnit + j;
+			glUniform1iv(location, arraySize, &units[0]);
+			reflection.samplerUnits[name] = nextUnit;
+			nextUnit += arraySize;
+		}
+	}
+	Core::UseProgram(0);
+}
+
+Uniform Shader_Loader::GetUniform(GLuint program, const char* name) const
+{
+	Uniform uniform;
+	auto programIt = reflections.find(program);
+	if (programIt == reflections.end())
+		return uniform;
+	auto it = programIt->second.uniformLocations.find(name);
+	if (it != programIt->second.uniformLocations.end())
+		uniform.location = it->second;
+	return uniform;
+}
+
+Sampler Shader_Loader::GetSampler(GLuint program, const char* name) const
+{
+	Sampler sampler;
+	auto programIt = reflections.find(program);
+	if (programIt == reflections.end())
+		return sampler;
+	auto it = programIt->second.samplerUnits.find(name);
+	if (it != programIt->second.samplerUnits.end())
+		sampler.unit = it->second;
+	return sampler;
+}
+
 void Shader_Loader::DeleteProgram( GLuint program )
 {
+	reflections.erase(program);
 	glDeleteProgram(program);
 }
@@ -3,18 +3,40 @@
 #include "glew.h"
 #include "freeglut.h"
 #include <iostream>
+#include <map>
+#include <string>
 
 namespace Core
 {
+	// Uniform location resolved once after the program is linked.
+	struct Uniform
+	{
+		GLint location = -1;
+	};
+
+	// Texture unit assigned to a sampler uniform at link time.
+	struct Sampler
+	{
+		GLint unit = -1;
+	};
+
+	struct ProgramReflection
+	{
+		std::map<std::string, GLint> uniformLocations;
+		std::map<std::string, GLint> samplerUnits;
+	};
 
 	class Shader_Loader
 	{
 	private:
 
+		std::map<GLuint, ProgramReflection> reflections;
+
 		std::string ReadShader(char *filename);
 		GLuint CreateShader(GLenum shaderType,
 			std::string source,
 			char* shaderName);
+		void ReflectProgram(GLuint program);
 
 	public:
 
@@ -23,7 +45,12 @@ namespace Core
 		GLuint CreateProgram(char* VertexShaderFilename,
 			char* FragmentShaderFilename);
 
+		// Lookups go through the table built in CreateProgram, never through the driver.
+		// Names that are not active in the program give a handle that GL ignores.
+		Uniform GetUniform(GLuint program, const char* name) const;
+		Sampler GetSampler(GLuint program, const char* name) const;
+
 		void DeleteProgram(GLuint program);
 
 	};
-}
\ No newline at end of file
+}
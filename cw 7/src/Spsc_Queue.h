@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace Core
+{
+	// Bounded lock-free queue for one producer thread and one consumer thread. Capacity is
+	// a power of two; a full queue rejects the push and leaves the choice to the producer.
+	template <typename T, size_t Capacity>
+	class SpscQueue
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	public:
+		SpscQueue() : head(0), tail(0) {}
+
+		bool Push(const T& value)
+		{
+			size_t head = this->head.load(std::memory_order_relaxed);
+			if (head - this->tail.load(std::memory_order_acquire) == Capacity)
+				return false;
+			this->items[head & (Capacity - 1)] = value;
+			this->head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(T& value)
+		{
+			size_t tail = this->tail.load(std::memory_order_relaxed);
+			if (tail == this->head.load(std::memory_order_acquire))
+				return false;
+			value = this->items[tail & (Capacity - 1)];
+			this->tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T items[Capacity];
+		// producer and consumer indices on separate cache lines
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+	};
+}
@@ -2,6 +2,7 @@
  
 #include "glew.h"
 #include "glm.hpp"
+#include "Entity_Store.h"
 #include <iostream>
 #include <map>
 #include <vector>
@@ -18,47 +19,39 @@ struct Contexts {
     Core::RenderContext circleContext;
 };
 
-struct TextureSet {
-    GLuint albedo;
-    GLuint normal;
-    GLuint ao;
-    GLuint roughness;
-    GLuint metallic;
+// Material indices in the MaterialLibrary; the maps themselves live in its texture array.
+struct PlanetMaterials {
+    int mercury;
+    int venus;
+    int earth;
+    int mars;
+    int jupiter;
+    int saturn;
+    int uran;
+    int neptune;
 };
 
-struct PlanetTextures {
-    TextureSet mercury;
-    TextureSet venus;
-    TextureSet earth;
-    TextureSet mars;
-    TextureSet jupiter;
-    TextureSet saturn;
-    TextureSet uran;
-    TextureSet neptune;
-};
-
-struct Textures {
-    TextureSet sun;
-    TextureSet spaceship;
-    PlanetTextures planets;
-    TextureSet trash1;
-    TextureSet trash2;
-    TextureSet asteroid;
-    TextureSet laser;
-    TextureSet barier;
-    TextureSet circle_bright;
-    TextureSet circle_dark;
-};
-
-struct ObjectInfo {
-    glm::vec3 coordinates;
-    float orbit;
-    bool destroyed = false;
+struct Materials {
+    int sun;
+    int spaceship;
+    PlanetMaterials planets;
+    int trash1;
+    int trash2;
+    int asteroid;
+    int laser;
+    int barier;
+    int circle_bright;
+    int circle_dark;
 };
 
+// What the ship and the laser collide with: the sun and the planets in one store, the trash
+// in another. Trash that was shot loses ENTITY_VISIBLE but keeps colliding, as it always has.
 struct Planets {
-    std::map<std::string, ObjectInfo> planetsProperties;
-    std::map<std::string, std::vector<ObjectInfo>> trashProperties;
+    Core::EntityStore bodies;
+    Core::EntityStore trash;
+    Core::EntityHandle sun;
+    Core::EntityHandle planets[8];
+    Core::EntityHandle trashPieces[8][4];
 };
 
 struct Laser {
@@ -71,6 +64,52 @@ struct Laser {
     Laser() : position(0.0f), direction(0.0f), startTime(0.0f), isActive(false) {}
 };
 
+struct BlurUniforms {
+    Core::Uniform horizontal;
+    Core::Sampler image;
+};
+
+struct BrightPassUniforms {
+    Core::Sampler scene;
+    Core::Uniform downscale;
+    Core::Uniform threshold;
+};
+
+struct BloomFinalUniforms {
+    Core::Uniform bloom;
+    Core::Uniform exposure;
+    Core::Uniform upscale;
+    Core::Sampler scene;
+    Core::Sampler bloomBlur;
+};
+
+struct Uniforms {
+    Core::DrawProgram programDefaultInstanced;
+    Core::DrawProgram programSun;
+    BlurUniforms programBlur;
+    BrightPassUniforms programBrightPass;
+    BloomFinalUniforms programBloomFinal;
+};
+
+// Model matrices gathered during the frame and drawn with one instanced call per mesh and texture set.
+struct InstanceBatches {
+    std::vector<glm::mat4> asteroids;
+    std::vector<glm::mat4> trash1;
+    std::vector<glm::mat4> trash2;
+    std::vector<glm::mat4> bariers;
+    std::vector<glm::mat4> circlesBright;
+    std::vector<glm::mat4> circlesDark;
+
+    void clear() {
+        asteroids.clear();
+        trash1.clear();
+        trash2.clear();
+        bariers.clear();
+        circlesBright.clear();
+        circlesDark.clear();
+    }
+};
+
 struct TextureSprite {
     GLuint sprite_1;
     GLuint sprite_2;
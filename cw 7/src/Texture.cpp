@@ -1,4 +1,6 @@
 #include "Texture.h"
+#include "Cpu_Profiler.h"
+#include "Render_State.h"
 
 #include <fstream> 
 #include <iostream>
@@ -8,58 +10,92 @@
 
 typedef unsigned char byte;
 
-GLuint Core::LoadTexture( const char * filepath )
+Core::ImageData Core::DecodeImage(const char * filepath)
+{
+	PROFILE_FUNCTION();
+	ImageData image;
+	image.pixels = SOIL_load_image(filepath, &image.width, &image.height, 0, SOIL_LOAD_RGBA);
+	// the result is kept per thread, so this is the reason of this load even on a worker
+	if (!image.pixels)
+		std::cout << "failed to load " << filepath << ": " << SOIL_last_result() << std::endl;
+	return image;
+}
+
+void Core::FreeImage(ImageData& image)
+{
+	SOIL_free_image_data(image.pixels);
+	image.pixels = nullptr;
+}
+
+GLuint Core::CreateTexture(const ImageData& image)
 {
 	GLuint id;
 	glGenTextures(1, &id);
-	glBindTexture(GL_TEXTURE_2D, id);
+	Core::BindTexture(GL_TEXTURE_2D, id);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	int w, h;
-	unsigned char* image = SOIL_load_image(filepath, &w, &h, 0, SOIL_LOAD_RGBA);
-	
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
 	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
 
 	return id;
 }
 
+GLuint Core::LoadTexture( const char * filepath )
+{
+	PROFILE_FUNCTION();
+	ImageData image = DecodeImage(filepath);
+	GLuint id = CreateTexture(image);
+	FreeImage(image);
+	return id;
+}
+
 void Core::SetActiveTexture(GLuint textureID, const char * shaderVariableName, GLuint programID, int textureUnit)
 {
 	glUniform1i(glGetUniformLocation(programID, shaderVariableName), textureUnit);
-	glActiveTexture(GL_TEXTURE0 + textureUnit);
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	Core::BindTextureUnit(textureUnit, GL_TEXTURE_2D, textureID);
 }
 
-GLuint Core::LoadSkybox(const std::string filepaths[6])
+void Core::SetActiveTexture(GLuint textureID, Sampler sampler)
 {
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-	int w, h;
-	unsigned char* data;
+	Core::BindTextureUnit(sampler.unit, GL_TEXTURE_2D, textureID);
+}
 
+GLuint Core::LoadSkybox(const std::string filepaths[6])
+{
+	ImageData faces[6];
 	for (unsigned int i = 0; i < 6; i++)
 	{
-		data = SOIL_load_image(filepaths[i].c_str(), &w, &h, 0, SOIL_LOAD_RGBA);
-		if (!data)
-		{
+		faces[i] = DecodeImage(filepaths[i].c_str());
+		if (!faces[i].pixels)
 			std::cerr << "Error loading image: " << filepaths[i] << std::endl;
+	}
+	GLuint textureID = CreateSkybox(faces);
+	for (unsigned int i = 0; i < 6; i++)
+		FreeImage(faces[i]);
+	return textureID;
+}
+
+GLuint Core::CreateSkybox(const ImageData faces[6])
+{
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		if (!faces[i].pixels)
 			return 0;
-		}
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	Core::BindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
+	for (unsigned int i = 0; i < 6; i++)
+	{
 		glTexImage2D(
 			GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-			0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data
+			0, GL_RGBA, faces[i].width, faces[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, faces[i].pixels
 		);
-
-		SOIL_free_image_data(data);
 	}
 
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
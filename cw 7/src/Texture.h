@@ -4,10 +4,27 @@
 #include "freeglut.h"
 #include <ext.hpp>
 #include <iostream>
+#include "Shader_Loader.h"
 
 namespace Core
 {
+	// Pixels of an image file in RGBA. Decoding touches no GL state, so it can run on any
+	// thread; the texture is then created from it on the thread that owns the context.
+	struct ImageData
+	{
+		int width = 0;
+		int height = 0;
+		unsigned char* pixels = nullptr;
+	};
+
+	// Leaves pixels null when the file does not load.
+	ImageData DecodeImage(const char * filepath);
+	void FreeImage(ImageData& image);
+	GLuint CreateTexture(const ImageData& image);
+	GLuint CreateSkybox(const ImageData faces[6]);
+
 	GLuint LoadTexture(const char * filepath);
 	void SetActiveTexture(GLuint textureID, const char * shaderVariableName, GLuint programID, int textureUnit);
+	void SetActiveTexture(GLuint textureID, Sampler sampler);
 	GLuint LoadSkybox(const std::string filepaths[6]);
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "Transform_Batch.h"
+
+#include "ext.hpp"
+#include "simd/matrix.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    // The kernel is written once against these and instantiated for the widest set the
+    // build targets. Everything stays in float, AVX without AVX2 has no 8-wide integer ops.
+    struct Sse
+    {
+        typedef __m128 V;
+        static const int WIDTH = 4;
+        static V Set(float value) { return _mm_set1_ps(value); }
+        static V Load(const float* values) { return _mm_loadu_ps(values); }
+        static V Add(V a, V b) { return _mm_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V And(V a, V b) { return _mm_and_ps(a, b); }
+        static V Xor(V a, V b) { return _mm_xor_ps(a, b); }
+        static V Select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        static V Equal(V a, V b) { return _mm_cmpeq_ps(a, b); }
+        static V Truncate(V a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+
+        // rows[r] holds component r of a column for each lane; writes that column of each object
+        static void StoreColumn(const V rows[4], glm::mat4* matrices, int column)
+        {
+            V r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = rows[3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&matrices[0][column][0], r0);
+            _mm_storeu_ps(&matrices[1][column][0], r1);
+            _mm_storeu_ps(&matrices[2][column][0], r2);
+            _mm_storeu_ps(&matrices[3][column][0], r3);
+        }
+    };
+#endif
+
+#if GLM_ARCH & GLM_ARCH_AVX_BIT
+    struct Avx
+    {
+        typedef __m256 V;
+        static const int WIDTH = 8;
+        static V Set(float value) { return _mm256_set1_ps(value); }
+        static V Load(const float* values) { return _mm256_loadu_ps(values); }
+        static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V And(V a, V b) { return _mm256_and_ps(a, b); }
+        static V Xor(V a, V b) { return _mm256_xor_ps(a, b); }
+        static V Select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+        static V Equal(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+        static V Truncate(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+        // the two halves are transposed as two groups of four objects
+        static void StoreColumn(const V rows[4], glm::mat4* matrices, int column)
+        {
+            Sse::V low[4], high[4];
+            for (int r = 0; r < 4; r++)
+            {
+                low[r] = _mm256_castps256_ps128(rows[r]);
+                high[r] = _mm256_extractf128_ps(rows[r], 1);
+            }
+            Sse::StoreColumn(low, matrices, column);
+            Sse::StoreColumn(high, matrices + 4, column);
+        }
+    };
+    typedef Avx Lanes;
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+    typedef Sse Lanes;
+#endif
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    // Sine and cosine of every lane, as in Cephes sinf/cosf: reduced to [-pi/4, pi/4] by
+    // octant and evaluated with its polynomials, within a few ulp for |x| below 8192.
+    template <typename L>
+    void SinCos(typename L::V x, typename L::V& sine, typename L::V& cosine)
+    {
+        typedef typename L::V V;
+        const V signBit = L::Set(-0.f);
+        V sineSign = L::And(x, signBit);
+        x = L::Xor(x, sineSign);
+
+        // octant rounded up to even, so the remainder lies in [-pi/4, pi/4]
+        V octant = L::Truncate(L::Mul(x, L::Set(1.27323954473516f)));
+        V odd = L::Sub(octant, L::Mul(L::Set(2.f), L::Truncate(L::Mul(octant, L::Set(0.5f)))));
+        octant = L::Add(octant, odd);
+        V y = L::Sub(x, L::Mul(octant, L::Set(0.78515625f)));
+        y = L::Sub(y, L::Mul(octant, L::Set(2.4187564849853515625e-4f)));
+        y = L::Sub(y, L::Mul(octant, L::Set(3.77489497744594108e-8f)));
+
+        // octant modulo 8 is 0, 2, 4 or 6
+        V quadrant = L::Sub(octant, L::Mul(L::Set(8.f), L::Truncate(L::Mul(octant, L::Set(0.125f)))));
+        V two = L::Equal(quadrant, L::Set(2.f));
+        V four = L::Equal(quadrant, L::Set(4.f));
+        V six = L::Equal(quadrant, L::Set(6.f));
+
+        V z = L::Mul(y, y);
+        V sinPoly = L::Add(L::Mul(L::Mul(L::Add(L::Mul(L::Add(L::Mul(L::Set(-1.9515295891e-4f), z), L::Set(8.3321608736e-3f)), z), L::Set(-1.6666654611e-1f)), z), y), y);
+        V cosPoly = L::Add(L::Sub(L::Mul(L::Mul(L::Add(L::Mul(L::Add(L::Mul(L::Set(2.443315711809948e-5f), z), L::Set(-1.388731625493765e-3f)), z), L::Set(4.166664568298827e-2f)), z), z), L::Mul(L::Set(0.5f), z)), L::Set(1.f));
+
+        // in the odd quarter turns the two polynomials trade places
+        V swap = L::Select(two, two, six);
+        sine = L::Select(swap, cosPoly, sinPoly);
+        cosine = L::Select(swap, sinPoly, cosPoly);
+        sine = L::Xor(sine, L::Xor(sineSign, L::And(L::Select(four, four, six), signBit)));
+        cosine = L::Xor(cosine, L::And(L::Select(two, two, four), signBit));
+    }
+
+    // Objects [first, first + WIDTH): R = Ry(yaw) * Rx(pitch), columns scaled, translation last.
+    template <typename L>
+    void ComposeLanes(const Core::TransformBatch& batch, int first, const glm::mat4* viewProjection,
+        glm::mat4* models, glm::mat4* modelViewProjections)
+    {
+        typedef typename L::V V;
+        V sinYaw, cosYaw, sinPitch, cosPitch;
+        SinCos<L>(L::Load(&batch.yaw[first]), sinYaw, cosYaw);
+        SinCos<L>(L::Load(&batch.pitch[first]), sinPitch, cosPitch);
+        V scale = L::Load(&batch.scale[first]);
+        V zero = L::Set(0.f);
+
+        // m[column][row]
+        V m[4][4];
+        m[0][0] = L::Mul(cosYaw, scale);
+        m[0][1] = zero;
+        m[0][2] = L::Mul(L::Sub(zero, sinYaw), scale);
+        m[1][0] = L::Mul(L::Mul(sinYaw, sinPitch), scale);
+        m[1][1] = L::Mul(cosPitch, scale);
+        m[1][2] = L::Mul(L::Mul(cosYaw, sinPitch), scale);
+        m[2][0] = L::Mul(L::Mul(sinYaw, cosPitch), scale);
+        m[2][1] = L::Mul(L::Sub(zero, sinPitch), scale);
+        m[2][2] = L::Mul(L::Mul(cosYaw, cosPitch), scale);
+        m[0][3] = m[1][3] = m[2][3] = zero;
+        m[3][0] = L::Load(&batch.x[first]);
+        m[3][1] = L::Load(&batch.y[first]);
+        m[3][2] = L::Load(&batch.z[first]);
+        m[3][3] = L::Set(1.f);
+        for (int column = 0; column < 4; column++)
+            L::StoreColumn(m[column], models + first, column);
+
+        if (!viewProjection)
+            return;
+        // the model's last row is (0, 0, 0, 1), so each product column needs three terms, the last one four
+        const glm::mat4& vp = *viewProjection;
+        for (int column = 0; column < 4; column++)
+        {
+            V rows[4];
+            for (int row = 0; row < 4; row++)
+            {
+                V sum = L::Add(L::Add(L::Mul(L::Set(vp[0][row]), m[column][0]), L::Mul(L::Set(vp[1][row]), m[column][1])),
+                    L::Mul(L::Set(vp[2][row]), m[column][2]));
+                rows[row] = column == 3 ? L::Add(sum, L::Set(vp[3][row])) : sum;
+            }
+            L::StoreColumn(rows, modelViewProjections + first, column);
+        }
+    }
+#endif
+
+    void ComposeRange(const Core::TransformBatch& batch, int begin, int end, const glm::mat4* viewProjection,
+        glm::mat4* models, glm::mat4* modelViewProjections)
+    {
+        int index = begin;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        for (; index + Lanes::WIDTH <= end; index += Lanes::WIDTH)
+            ComposeLanes<Lanes>(batch, index, viewProjection, models, modelViewProjections);
+#endif
+        for (; index < end; index++)
+        {
+            models[index] = Core::ComposeTransformScalar(batch, index);
+            if (!viewProjection)
+                continue;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+            // glm's SSE product wants aligned columns, glm::mat4 does not guarantee them
+            glm_vec4 a[4], b[4], product[4];
+            for (int column = 0; column < 4; column++)
+            {
+                a[column] = _mm_loadu_ps(&(*viewProjection)[column][0]);
+                b[column] = _mm_loadu_ps(&models[index][column][0]);
+            }
+            glm_mat4_mul(a, b, product);
+            for (int column = 0; column < 4; column++)
+                _mm_storeu_ps(&modelViewProjections[index][column][0], product[column]);
+#else
+            modelViewProjections[index] = *viewProjection * models[index];
+#endif
+        }
+    }
+
+    void ComposeScalarRange(const Core::TransformBatch& batch, int count, const glm::mat4& viewProjection,
+        glm::mat4* models, glm::mat4* modelViewProjections)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            models[i] = Core::ComposeTransformScalar(batch, i);
+            modelViewProjections[i] = viewProjection * models[i];
+        }
+    }
+}
+
+void Core::TransformBatch::Clear()
+{
+    this->Resize(0);
+}
+
+void Core::TransformBatch::Resize(int count)
+{
+    this->x.resize(count);
+    this->y.resize(count);
+    this->z.resize(count);
+    this->yaw.resize(count);
+    this->pitch.resize(count);
+    this->scale.resize(count);
+}
+
+void Core::TransformBatch::Set(int index, const glm::vec3& position, float yaw, float pitch, float scale)
+{
+    this->x[index] = position.x;
+    this->y[index] = position.y;
+    this->z[index] = position.z;
+    this->yaw[index] = yaw;
+    this->pitch[index] = pitch;
+    this->scale[index] = scale;
+}
+
+int Core::TransformBatch::Add(const glm::vec3& position, float yaw, float pitch, float scale)
+{
+    int index = this->GetCount();
+    this->Resize(index + 1);
+    this->Set(index, position, yaw, pitch, scale);
+    return index;
+}
+
+void Core::ComposeTransforms(const TransformBatch& batch, int begin, int end, glm::mat4* models)
+{
+    ComposeRange(batch, begin, end, nullptr, models, nullptr);
+}
+
+void Core::ComposeTransforms(const TransformBatch& batch, int begin, int end, const glm::mat4& viewProjection,
+    glm::mat4* models, glm::mat4* modelViewProjections)
+{
+    ComposeRange(batch, begin, end, &viewProjection, models, modelViewProjections);
+}
+
+glm::mat4 Core::ComposeTransformScalar(const TransformBatch& batch, int index)
+{
+    return glm::translate(glm::vec3(batch.x[index], batch.y[index], batch.z[index])) *
+        glm::rotate(batch.yaw[index], glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::rotate(batch.pitch[index], glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::scale(glm::vec3(batch.scale[index]));
+}
+
+void Core::RunTransformBenchmark()
+{
+    const int counts[3] = { 10000, 100000, 1000000 };
+    const int repeats = 10;
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.05f, 2000.f) *
+        glm::lookAt(glm::vec3(20.f, 0.f, 0.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    std::cout << "transform benchmark: kernel composes " << Lanes::WIDTH << " objects per iteration" << std::endl;
+#else
+    std::cout << "transform benchmark: built without SSE2, the kernel is the scalar path" << std::endl;
+#endif
+    std::default_random_engine generator;
+    std::uniform_real_distribution<float> position(-300.f, 300.f);
+    // spin angles of a game running for a few minutes
+    std::uniform_real_distribution<float> angle(-600.f, 600.f);
+    std::uniform_real_distribution<float> scale(0.5f, 25.f);
+
+    for (int count : counts)
+    {
+        TransformBatch batch;
+        for (int i = 0; i < count; i++)
+            batch.Add(glm::vec3(position(generator), position(generator), position(generator)), angle(generator), angle(generator), scale(generator));
+        std::vector<glm::mat4> scalarModels(count), scalarProducts(count), models(count), products(count);
+
+        auto time = [&](const std::function<void()>& work) {
+            work();
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; i++)
+                work();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+        };
+        double scalarSeconds = time([&]() { ComposeScalarRange(batch, count, viewProjection, scalarModels.data(), scalarProducts.data()); });
+        double kernelSeconds = time([&]() { ComposeTransforms(batch, 0, count, viewProjection, models.data(), products.data()); });
+
+        // the model matrices compare directly; the products are compared relative to their size
+        float modelError = 0.f, productError = 0.f;
+        for (int i = 0; i < count; i++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    float scaleOf = std::max(1.f, std::fabs(scalarProducts[i][column][row]));
+                    modelError = std::max(modelError, std::fabs(models[i][column][row] - scalarModels[i][column][row]) / std::max(1.f, std::fabs(scalarModels[i][column][row])));
+                    productError = std::max(productError, std::fabs(products[i][column][row] - scalarProducts[i][column][row]) / scaleOf);
+                }
+            }
+        }
+        std::cout << "  " << count << " objects: glm " << scalarSeconds * 1e9 / count << " ns/object, kernel "
+            << kernelSeconds * 1e9 / count << " ns/object, " << scalarSeconds / kernelSeconds << "x; largest relative difference "
+            << modelError << " (model), " << productError << " (model-view-projection)" << std::endl;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glm.hpp"
+#include <vector>
+
+namespace Core
+{
+	// Objects placed as translate * rotate(yaw, Y) * rotate(pitch, X) * scale, stored as one
+	// array per component so the kernel loads the same field of several objects at once.
+	// Every object of the scene fits this: planets have no rotation, trash and asteroids spin
+	// about Y and X, and all of them scale uniformly.
+	struct TransformBatch
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> yaw;
+		std::vector<float> pitch;
+		std::vector<float> scale;
+
+		int GetCount() const { return (int)this->x.size(); }
+		void Clear();
+		void Resize(int count);
+		void Set(int index, const glm::vec3& position, float yaw, float pitch, float scale);
+		int Add(const glm::vec3& position, float yaw, float pitch, float scale);
+	};
+
+	// Builds the model matrices of objects [begin, end). With AVX the kernel composes 8
+	// objects per iteration, with SSE2 4, the objects left over go through glm one by one.
+	// Ranges are independent, so separate jobs can compose parts of one batch.
+	void ComposeTransforms(const TransformBatch& batch, int begin, int end, glm::mat4* models);
+	// Also multiplies every model matrix by the view-projection.
+	void ComposeTransforms(const TransformBatch& batch, int begin, int end, const glm::mat4& viewProjection,
+		glm::mat4* models, glm::mat4* modelViewProjections);
+
+	// The glm chain the kernel replaces, for one object; the benchmark's reference.
+	glm::mat4 ComposeTransformScalar(const TransformBatch& batch, int index);
+
+	// Times the scalar glm chain against the kernel, both with the view-projection product,
+	// at 10k, 100k and 1M objects, and prints the largest difference between their results.
+	void RunTransformBenchmark();
+}
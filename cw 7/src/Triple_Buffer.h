@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+
+namespace Core
+{
+	// Lock-free hand-over of the latest value from one writer thread to one reader thread.
+	// Each side owns a slot and the third is the one in between; publishing and picking up
+	// swap a side's slot with it in one atomic exchange, so neither side ever waits and a
+	// value is never torn. Values the reader did not pick up in time are overwritten.
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() : back(0), middle(1), front(2) {}
+
+		// Slot the writer fills before Publish; its contents are whatever it wrote two publishes ago.
+		T& GetWriteSlot() { return this->slots[this->back]; }
+
+		void Publish()
+		{
+			this->back = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+
+		// Latest published value; stays valid and unchanged until the next Read.
+		const T& Read()
+		{
+			if (this->middle.load(std::memory_order_relaxed) & FRESH)
+				this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & INDEX;
+			return this->slots[this->front];
+		}
+
+	private:
+		static const int INDEX = 3;
+		// set while the middle slot holds a value the reader has not taken
+		static const int FRESH = 4;
+
+		T slots[3];
+		int back;
+		std::atomic<int> middle;
+		int front;
+	};
+}
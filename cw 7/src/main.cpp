@@ -12,9 +12,18 @@
 
 int main(int argc, char** argv)
 {
+	parseArguments(argc, argv);
+	// measures the CPU kernel alone, no window needed
+	if (transformBenchmark)
+	{
+		Core::RunTransformBenchmark();
+		return 0;
+	}
+
 	// inicjalizacja glfw
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	// multi-draw indirect, storage buffers, separate vertex formats and debug groups are 4.3
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -22,26 +31,47 @@ int main(int argc, char** argv)
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-	GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
-	const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
-
-	GLFWwindow* window = glfwCreateWindow(mode->width, mode->height, "Cosmos Game", primaryMonitor, NULL);
+	GLFWwindow* window;
+	if (benchmark.enabled)
+	{
+		// hidden window of the benchmark size; with Mesa under Xvfb it runs without a GPU
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(benchmark.width, benchmark.height, "Cosmos Game benchmark", NULL, NULL);
+	}
+	else
+	{
+		GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
+		const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
+		window = glfwCreateWindow(mode->width, mode->height, "Cosmos Game", primaryMonitor, NULL);
+	}
 	if (window == NULL)
 	{
-		std::cout << "Failed to create GLFW window" << std::endl;
+		std::cout << "Failed to create GLFW window with an OpenGL 4.3 core context" << std::endl;
 		glfwTerminate();
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
 
 	// ladowanie OpenGL za pomoca glew
-	glewInit();
-	glViewport(0, 0, mode->width, mode->height);
+	// core contexts of Mesa only expose their entry points to GLEW in experimental mode
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK || !GLEW_VERSION_4_3)
+	{
+		const GLubyte* version = glGetString(GL_VERSION);
+		std::cout << "OpenGL 4.3 is required, the driver reports " << (version ? (const char*)version : "no version") << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
 	init(window);
 
 	// uruchomienie glownej petli
-	renderLoop(window);
+	if (jobBenchmark)
+		runJobBenchmark();
+	else if (benchmark.enabled)
+		runBenchmark(window);
+	else
+		renderLoop(window);
 
 	shutdown(window);
 	glfwTerminate();
@@ -4,12 +4,32 @@
 #include "ext.hpp"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #include "Shader_Loader.h"
 #include "Render_Utils.h"
 #include "Render_Sprite.h"
 #include "Texture.h"
+#include "Benchmark.h"
+#include "Bloom_Pyramid.h"
+#include "Broadphase.h"
+#include "Cpu_Profiler.h"
+#include "Dynamic_Resolution.h"
+#include "Fixed_Timestep.h"
+#include "Frame_Uniforms.h"
+#include "Geometry_Arena.h"
+#include "Gpu_Profiler.h"
+#include "Input_Recorder.h"
+#include "Job_System.h"
+#include "Material_Library.h"
+#include "Render_Graph.h"
+#include "Render_Queue.h"
+#include "Render_State.h"
+#include "Render_Targets.h"
+#include "Spsc_Queue.h"
 #include "Structures.h"
+#include "Transform_Batch.h"
+#include "Triple_Buffer.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -17,17 +37,9 @@
 #include <string>
 #include <random>
 #include <chrono>
-
-std::map<std::string, std::map<int, bool>> trashDisplayInfoMap = {
-	{"Mercury", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Venus", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Earth", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Mars", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Jupiter", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Saturn", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Uran", {{0, true}, {1, true}, {2, true}, {3, true}}},
-	{"Neptun", {{0, true}, {1, true}, {2, true}, {3, true}}},
-};
+#include <cstdlib>
+#include <atomic>
+#include <thread>
 
 std::vector<std::vector<glm::vec3>> asteroidPositions(4, std::vector<glm::vec3>(8, glm::vec3(0.f, 0.f, 0.f)));
 
@@ -42,21 +54,60 @@ std::map<int, std::pair<glm::vec3, bool>> circlePositions{
 		{8, {glm::vec3(-30.f, -50.f, -58.f), false}}
 };
 
-Textures textures;
+Materials materials;
+Uniforms uniforms;
+InstanceBatches instanceBatches;
 TextureSprite sprites;
 Planets planets;
 Laser laser;
 Contexts contexts;
 
-GLuint programDefault;
+// What a collision query tests against; the ship hits everything, the laser flies
+// through the checkpoints.
+enum CollisionLayer
+{
+	LAYER_BODY = 1 << 0,
+	LAYER_ASTEROID = 1 << 1,
+	LAYER_TRASH = 1 << 2,
+	LAYER_CHECKPOINT = 1 << 3,
+	LAYER_SHIP_HITS = LAYER_BODY | LAYER_ASTEROID | LAYER_TRASH | LAYER_CHECKPOINT,
+	LAYER_LASER_HITS = LAYER_BODY | LAYER_ASTEROID | LAYER_TRASH,
+};
+
+// Everything collidable at the current step, refilled by the step; used by the simulation only.
+Core::Broadphase collisionWorld;
+std::vector<int> collisionCandidates;
+// how far the bodies, the trash and the asteroids moved over the step, for swept queries
+std::vector<glm::vec3> bodyMotion;
+std::vector<glm::vec3> trashMotion;
+std::vector<std::vector<glm::vec3>> previousAsteroidPositions(4, std::vector<glm::vec3>(8, glm::vec3(0.f, 0.f, 0.f)));
+
+GLuint programDefaultInstanced;
 GLuint programSun;
 GLuint programSprite;
 GLuint programSkybox;
 GLuint skyboxTexture;
 GLuint programBlur;
+GLuint programBrightPass;
+GLuint programBloomDown;
+GLuint programBloomUp;
 GLuint programBloomFinal;
 
 Core::Shader_Loader shaderLoader;
+Core::JobSystem jobSystem;
+Core::FrameUniformBuffer frameUniformBuffer;
+Core::MaterialLibrary materialLibrary;
+Core::GeometryArena geometryArena;
+Core::BloomPyramid bloomPyramid;
+Core::RenderGraph renderGraph;
+Core::DynamicResolution dynamicResolution;
+Core::GpuProfiler gpuProfiler;
+// per-pass GPU times are written here on exit, set with --gpu-profile <path>
+std::string gpuProfilePath = "gpu_profile.csv";
+Core::RenderQueue renderQueue;
+Core::TransformBatch sceneTransforms;
+std::vector<glm::mat4> sceneMatrices;
+Core::CameraView cameraView;
 Core::RenderSprite* renderSprite;
 Core::RenderSprite* renderSpriteEnd;
 Core::RenderSprite* renderSpriteStart;
@@ -72,6 +123,11 @@ glm::vec3 spotlightColor = glm::vec3(0.4, 0.4, 0.9) * 3;
 float spotlightPhi = 3.14 / 4;
 
 float aspectRatio = 1.f;
+int framebufferWidth = 1920;
+int framebufferHeight = 1080;
+// size of the HDR and bloom targets, the framebuffer times the render scale
+int renderWidth = 0;
+int renderHeight = 0;
 float exposition = 1.f;
 
 glm::vec3 lightColor = glm::vec3(0.9, 0.7, 0.8) * 100;
@@ -84,8 +140,28 @@ float cameraUp = 0.0f;
 float spaceshipSide = 0.0f;
 float spaceshipUp = 0.0f;
 
-float lastTime = -1.f;
-float deltaTime = 0.f;
+
+// --benchmark renders on a simulated clock along a scripted path instead of player input
+Core::BenchmarkSettings benchmark;
+Core::BenchmarkRecorder benchmarkRecorder;
+bool jobBenchmark = false;
+bool transformBenchmark = false;
+bool benchmarkMeasuring = false;
+double simulatedTime = 0.0;
+
+// seconds of game time; the wall clock, or the simulated one of a benchmark
+float getTime() {
+	return benchmark.enabled ? (float)simulatedTime : (float)glfwGetTime();
+}
+
+// Input of the current frame. The simulation reads only this, so a frame fed from a
+// recording (--replay) plays out exactly as the recorded one (--record).
+Core::FrameInput frameInput;
+Core::InputRecorder inputRecorder;
+Core::InputReplay inputReplay;
+
+const float STATS_REPORT_INTERVAL = 5.f;
+float lastStatsReportTime = 0.f;
 
 float spaceshipRadius = 0.5f;
 int trashDestroyed = 0;
@@ -95,203 +171,275 @@ bool raceCompleted = false;
 bool trashCompleted = false;
 int circleVisited = 0;
 
-std::chrono::time_point<std::chrono::steady_clock> start_time;
-std::chrono::time_point<std::chrono::steady_clock> end_time;
+// step time of the first checkpoint of the race; game time, so a replay finishes it the same
+float raceStartTime = 0.f;
+const float RACE_TIME_LIMIT = 15.f;
 
 float exposure = 0.8f;
-unsigned int hdrFBO;
-unsigned int pingpongFBO[2];
-unsigned int pingpongColorbuffers[2];
-unsigned int colorBuffers[2];
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-
-void updateDeltaTime(float time) {
-	if (lastTime < 0) {
-		lastTime = time;
-		return;
-	}
+// bloom source, extracted from the scene at a fraction of its size
+int brightWidth = 0;
+int brightHeight = 0;
+// formats and bright pass size of the targets, switched with P or --targets <quality|balanced|low>
+Core::RenderTargetProfile renderTargetProfile = Core::TARGET_PROFILE_BALANCED;
+bool profileKeyDown = false;
+// used by the bright pass when the scene format has no alpha for the per-material thresholds
+const float GLOBAL_BLOOM_THRESHOLD = 0.5f;
+// surfaces that are not in the material library
+const float SKYBOX_BLOOM_THRESHOLD = 0.6f;
+const float SPRITE_BLOOM_THRESHOLD = 0.6f;
+const float EMISSIVE_BLOOM_THRESHOLD = 0.1f;
+
+// Bloom path of renderScene, switched with B: the original separable Gaussian over
+// ping-pong buffers, or the dual-filter pyramid.
+enum BloomMode { BLOOM_GAUSSIAN = 0, BLOOM_PYRAMID };
+BloomMode bloomMode = BLOOM_PYRAMID;
+bool bloomKeyDown = false;
+const unsigned int GAUSSIAN_BLUR_PASSES = 20;
+
+void updateFrameUniforms() {
+	glm::mat4 cameraMatrix = Core::createCameraMatrix(cameraDir, cameraPos);
+	glm::mat4 perspectiveMatrix = Core::createPerspectiveMatrix(aspectRatio);
+
+	Core::FrameUniforms frame = {};
+	frame.viewProjection = perspectiveMatrix * cameraMatrix;
+	cameraView.frustum = Core::ExtractFrustum(frame.viewProjection);
+	cameraView.position = cameraPos;
+	cameraView.projectionScale = perspectiveMatrix[1][1];
+	frame.skyboxViewProjection = perspectiveMatrix * glm::mat4(glm::mat3(cameraMatrix));
+	frame.cameraPos = cameraPos;
+	frame.exposition = exposition;
+	frame.lightPos = glm::vec3(0.0f, 0.0f, 0.0f);
+	frame.lightColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	frame.spotlightPos = spotlightPos;
+	frame.spotlightConeDir = spotlightConeDir;
+	frame.spotlightColor = spotlightColor;
+	frame.spotlightPhi = spotlightPhi;
+	frameUniformBuffer.Update(frame);
+}
+
+void submitDraw(unsigned pass, const Core::DrawProgram& program, Core::RenderContext& context, int material, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* instances) {
+	Core::DrawItem item;
+	item.program = &program;
+	item.context = &context;
+	item.material = material;
+	item.modelMatrix = modelMatrix;
+	item.instances = instances;
+
+	float depth = instances == nullptr ? glm::length(glm::vec3(modelMatrix[3]) - cameraPos) : 0.f;
+	item.key = Core::MakeSortKey(pass, program.id, material, context.meshIndex, depth);
+	renderQueue.Submit(item);
+}
+
+void drawObjectTexture(Core::RenderContext& context, int material, glm::mat4 modelMatrix) {
+	submitDraw(Core::PASS_OPAQUE, uniforms.programDefaultInstanced, context, material, modelMatrix, nullptr);
+}
 
-	deltaTime = time - lastTime;
-	if (deltaTime > 0.1) deltaTime = 0.1;
-	lastTime = time;
+void drawObjectInstanced(Core::RenderContext& context, int material, const std::vector<glm::mat4>& modelMatrices) {
+	submitDraw(Core::PASS_OPAQUE, uniforms.programDefaultInstanced, context, material, glm::mat4(1.0f), &modelMatrices);
 }
 
-void renderQuad()
+const glm::vec3 SUN_POSITION = glm::vec3(0, 0, 0);
+
+// Orbits of the planets and of the trash around them, shared by the simulation and the render.
+struct PlanetOrbit
 {
-	if (quadVAO == 0)
-	{
-		float quadVertices[] = {
-			-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-			-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-			 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-			 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-		};
-		glGenVertexArrays(1, &quadVAO);
-		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	}
-	glBindVertexArray(quadVAO);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
-}
-
-void drawObjectTexture(GLuint program,Core::RenderContext& context, TextureSet textures, glm::mat4 modelMatrix) {
-
-	glm::mat4 viewProjectionMatrix = Core::createPerspectiveMatrix(aspectRatio) * Core::createCameraMatrix(cameraDir, cameraPos);
-	glm::mat4 transformation = viewProjectionMatrix * modelMatrix;
-
-	glUseProgram(programDefault);
-	glUniformMatrix4fv(glGetUniformLocation(program, "transformation"), 1, GL_FALSE, (float*)&transformation);
-	glUniformMatrix4fv(glGetUniformLocation(program, "modelMatrix"), 1, GL_FALSE, (float*)&modelMatrix);
-	glUniform1f(glGetUniformLocation(program, "exposition"), exposition);
-	glUniform3f(glGetUniformLocation(program, "cameraPos"), cameraPos.x, cameraPos.y, cameraPos.z);
-	glUniform3f(glGetUniformLocation(program, "lightPos"), 0.0f, 0.0f, 0.0f);
-	glUniform3f(glGetUniformLocation(program, "lightColor"), 1.0f, 1.0f, 1.0f);
-	Core::SetActiveTexture(textures.albedo, "albedoTexture", program, 0);
-	Core::SetActiveTexture(textures.normal, "normalTexture", program, 1);
-	Core::SetActiveTexture(textures.ao, "aoTexture", program, 2);
-	Core::SetActiveTexture(textures.roughness, "roughnessTexture", program, 3);
-	Core::SetActiveTexture(textures.metallic, "metallicTexture", program, 4);
-	Core::DrawContext(context);
-
-}
-
-void drawTrash(float planetX, float planetZ, float time, float orbitRadius, glm::vec3 scalePlanet,std::string planetName) {
-	
+	const char* name;
+	float orbitRadius;
+	float orbitSpeed;
+	float scale;
+	float trashOrbitRadius;
+};
+
+const PlanetOrbit PLANET_ORBITS[8] = {
+	{ "Mercury", 15.0f * 5, 0.2f, 0.5f * 9, 1 * 9 },
+	{ "Venus", 20.0f * 5, 0.175f, 1.f * 9, 1.5f * 9 },
+	{ "Earth", 25.0f * 5, 0.15f, 1.3f * 9, 2 * 9 },
+	{ "Mars", 30.0f * 5, 0.125f, 1.3f * 9, 2 * 9 },
+	{ "Jupiter", 40.0f * 5, 0.1f, 2.5f * 9, 3 * 9 },
+	{ "Saturn", 50.0f * 5, 0.075f, 2.2f * 9, 3 * 9 },
+	{ "Uran", 55.0f * 5, 0.05f, 1.6f * 9, 2.5f * 9 },
+	{ "Neptun", 60.0f * 5, 0.025f, 1.8f * 9, 2.5f * 9 },
+};
+
+glm::vec3 planetPosition(const PlanetOrbit& orbit, float time) {
+	return glm::vec3(orbit.orbitRadius * cos(orbit.orbitSpeed * time), 0.f, orbit.orbitRadius * sin(orbit.orbitSpeed * time));
+}
+
+// Piece 0-3 of the trash around a planet: even pieces are the small ones circling one way,
+// odd pieces the large ones circling the other.
+glm::vec3 trashPosition(const glm::vec3& planetPos, float orbitRadius, float time, int piece) {
 	float orbitSpeed = 1.f;
-	int id=0;
-	const auto& trashProps = planets.trashProperties[planetName];
+	int i = piece / 2 + 1;
+	if (piece % 2 == 0)
+		return glm::vec3(planetPos.x + orbitRadius * cos(orbitSpeed * time + i * 100), 0.5f, planetPos.z + orbitRadius * sin(orbitSpeed * time + i * 50));
+	return glm::vec3(planetPos.x + orbitRadius * cos(orbitSpeed * time - i * 50), -0.5f, planetPos.z + orbitRadius * sin(orbitSpeed * time - i * 100));
+}
 
-	for (int i = 0; i < trashProps.size() && i < 4; ++i) {
-		if (trashProps[i].destroyed && trashDisplayInfoMap[planetName][i]) {
-			trashDisplayInfoMap[planetName][i] = false;
+// Counts the trash the last step destroyed and moves the collision spheres to the new time.
+void updateTrash(int planet, const glm::vec3& planetPos, float time, float orbitRadius) {
+	glm::vec3* positions = planets.trash.GetPositions();
+	uint32_t* flags = planets.trash.GetFlags();
+	for (int piece = 0; piece < 4; ++piece) {
+		int index = planets.trash.GetIndex(planets.trashPieces[planet][piece]);
+		if ((flags[index] & Core::ENTITY_HIT) && (flags[index] & Core::ENTITY_VISIBLE)) {
+			flags[index] &= ~Core::ENTITY_VISIBLE;
 			trashDestroyed++;
 		}
+		flags[index] &= ~Core::ENTITY_HIT;
+		positions[index] = trashPosition(planetPos, orbitRadius, time, piece);
 	}
+}
 
-	planets.trashProperties[planetName].clear();
+// Slots of a planet in a transform batch: the planet, then its four pieces of trash.
+const int PLANET_TRANSFORMS = 5;
+// Objects one transform job composes; the scene's few dozen stay on the calling thread.
+const int TRANSFORMS_PER_JOB = 4096;
+
+// Places a planet and its trash at a time into slots first to first + 4 of the batch.
+void setPlanetTransforms(const PlanetOrbit& orbit, float time, Core::TransformBatch& batch, int first) {
+	glm::vec3 position = planetPosition(orbit, time);
+	batch.Set(first, position, 0.f, 0.f, orbit.scale);
+	for (int piece = 0; piece < 4; ++piece)
+		batch.Set(first + 1 + piece, trashPosition(position, orbit.trashOrbitRadius, time, piece), 2.f * time, 0.5f * time, piece % 2 == 0 ? 0.7f : 1.5f);
+}
 
-	for (int i = 1; i <= 2; ++i) {
+void updatePlanet(int planet, float time) {
+	const PlanetOrbit& orbit = PLANET_ORBITS[planet];
+	glm::vec3 position = planetPosition(orbit, time);
+	planets.bodies.GetPositions()[planets.bodies.GetIndex(planets.planets[planet])] = position;
+	updateTrash(planet, position, time, orbit.trashOrbitRadius);
+}
 
-		float trashX1 = planetX + orbitRadius * cos(orbitSpeed * time + i * 100);
-		float trashZ1 = planetZ + orbitRadius * sin(orbitSpeed * time + i * 50);
-		glm::vec3 trashPos1(trashX1, 0.5f, trashZ1);
-		glm::mat4 modelMatrix1 = glm::translate(glm::vec3(trashX1, 0.5f, trashZ1)) *
-			glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) *
-			glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f)) *
-			glm::scale(glm::vec3(0.7f));
+// The sun, the planets with a collision radius just inside their trash orbit, and four
+// visible pieces of trash each. The steps move them; only the sun stays put.
+void initEntities() {
+	planets.bodies.Clear();
+	planets.trash.Clear();
+	planets.sun = planets.bodies.Create(SUN_POSITION, 30.f);
+	for (int i = 0; i < 8; i++)
+	{
+		planets.planets[i] = planets.bodies.Create(glm::vec3(0.f), PLANET_ORBITS[i].trashOrbitRadius - 1.f);
+		for (int piece = 0; piece < 4; piece++)
+			planets.trashPieces[i][piece] = planets.trash.Create(glm::vec3(0.f), 2.f, Core::ENTITY_VISIBLE);
+	}
+}
 
-		planets.trashProperties[planetName].push_back({ trashPos1, 2.f});
+// Takes the PLANET_TRANSFORMS matrices setPlanetTransforms placed, composed.
+void drawPlanet(Core::RenderContext& context, int material, const glm::mat4* transforms, const bool trashVisible[4]) {
+	PROFILE_FUNCTION();
+	submitDraw(Core::PASS_OPAQUE, uniforms.programDefaultInstanced, context, material, transforms[0], nullptr);
 
-		float trashX2 = planetX + orbitRadius * cos(orbitSpeed * time - i * 50);
-		float trashZ2 = planetZ + orbitRadius * sin(orbitSpeed * time - i * 100);
-		glm::vec3 trashPos2(trashX2, -0.5f, trashZ2);
-		glm::mat4 modelMatrix2 = glm::translate(glm::vec3(trashX2, -0.5f, trashZ2)) *
-			glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) *
-			glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f)) *
-			glm::scale(glm::vec3(1.5f));
+	for (int piece = 0; piece < 4; ++piece) {
+		if (trashVisible[piece])
+			(piece % 2 == 0 ? instanceBatches.trash1 : instanceBatches.trash2).push_back(transforms[1 + piece]);
+	}
+}
 
-		planets.trashProperties[planetName].push_back({ trashPos2,  2.f });
+// Asteroid field above the sun and the four asteroids circling the race track. Positions
+// go to the collision list, transforms to the render's batch; either may be null.
+void placeAsteroids(float time, std::vector<std::vector<glm::vec3>>* positions, Core::TransformBatch* transforms) {
+	glm::vec3 initialAsteroidPosition(0.f, 40.f, 0.f);
+	float offset = sin(time) * 2.0f;
 
-		if (trashDisplayInfoMap[planetName][id]) drawObjectTexture(programDefault, contexts.trash1Context, textures.trash1, modelMatrix1);
-		if (trashDisplayInfoMap[planetName][id + 1]) drawObjectTexture(programDefault, contexts.trash2Context, textures.trash2, modelMatrix2);
+	std::default_random_engine generator; // Inicjalizacja generatora liczb losowych
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f); // Zakres losowych wartoci od -1.0 do 1.0
 
-		id=id+2;
-	}
-}
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int col = 0; col < 8; ++col)
+		{
+			glm::vec3 position = initialAsteroidPosition + glm::vec3(col * 10.f, 0.f, row * 10.f);
+			if (row % 2 == 1) position.x += 10.f * 0.5f;
+			position.x += offset;
 
-void drawPlanet(Core::RenderContext& context, TextureSet textures, float planetOrbitRadius, float planetOrbitSpeed, float time, glm::vec3 scalePlanet, float trashOrbitRadius, std::string& planetName) {
-	float planetX = planetOrbitRadius * cos(planetOrbitSpeed * time);
-	float planetZ = planetOrbitRadius * sin(planetOrbitSpeed * time);
-	
-	planets.planetsProperties[planetName] = { glm::vec3(planetX,0.f,planetZ), trashOrbitRadius - 1.f };
-	glm::mat4 modelMatrix = glm::translate(glm::vec3(planetX, 0, planetZ)) * glm::scale(scalePlanet);
-	glm::mat4 viewProjectionMatrix = Core::createPerspectiveMatrix(aspectRatio) * Core::createCameraMatrix(cameraDir, cameraPos);
-	glm::mat4 transformation = viewProjectionMatrix * modelMatrix;
+			position.x += distribution(generator) * 5.f;
+			position.y += distribution(generator) * 5.f;
+			position.z += distribution(generator) * 5.f;
 
-	glUseProgram(programDefault);
-	glUniformMatrix4fv(glGetUniformLocation(programDefault, "transformation"), 1, GL_FALSE, (float*)&transformation);
-	glUniformMatrix4fv(glGetUniformLocation(programDefault, "modelMatrix"), 1, GL_FALSE, (float*)&modelMatrix);
-	glUniform1f(glGetUniformLocation(programDefault, "exposition"), exposition);
-	glUniform3f(glGetUniformLocation(programDefault, "cameraPos"), cameraPos.x, cameraPos.y, cameraPos.z);
-	glUniform3f(glGetUniformLocation(programDefault, "lightPos"), 0.0f, 0.0f, 0.0f);
-	glUniform3f(glGetUniformLocation(programDefault, "lightColor"), 1.0f, 1.0f, 1.0f);
-	glUniform3f(glGetUniformLocation(programDefault, "spotlightPos"), spotlightPos.x, spotlightPos.y, spotlightPos.z);
-	glUniform3f(glGetUniformLocation(programDefault, "spotlightConeDir"), spotlightConeDir.x, spotlightConeDir.y, spotlightConeDir.z);
-	glUniform3f(glGetUniformLocation(programDefault, "spotlightColor"), spotlightColor.r, spotlightColor.g, spotlightColor.b);
-	glUniform1f(glGetUniformLocation(programDefault, "spotlightPhi"), spotlightPhi);
-	Core::SetActiveTexture(textures.albedo, "albedoTexture", programDefault, 0);
-	Core::SetActiveTexture(textures.normal, "normalTexture", programDefault, 1);
-	Core::SetActiveTexture(textures.ao, "aoTexture", programDefault, 2);
-	Core::SetActiveTexture(textures.roughness, "roughnessTexture", programDefault, 3);
-	Core::SetActiveTexture(textures.metallic, "metallicTexture", programDefault, 4);
-	Core::DrawContext(context);
+			if (positions) (*positions)[row][col] = position;
+			if (transforms) transforms->Add(position, 2.f * time, 0.5f * time, 1.f);
+		}
+	}
 
-	drawTrash(planetX, planetZ, time, trashOrbitRadius,scalePlanet,planetName);
+	const glm::vec3 trackAsteroids[4] = {
+		glm::vec3(-58.f + 3 * sin(time * 2), -50.f, -8.f + 15.f * cos(time * 2)),
+		glm::vec3(58.f + 3 * sin(time * 2), -50.f, -8.f + 15.f * cos(time * 2)),
+		glm::vec3(-8.f + 15.f * cos(time * 2), -50.f, 58.f + 3 * sin(time * 2)),
+		glm::vec3(-8.f + 15.f * cos(time * 2), -50.f, -58.f + 3 * sin(time * 2)),
+	};
+	for (int i = 0; i < 4; ++i)
+	{
+		if (positions) (*positions)[3][i] = trackAsteroids[i];
+		if (transforms) transforms->Add(trackAsteroids[i], 2.f * time, 0.5f * time, 2.f);
+	}
 }
 
 glm::vec3 sunDirection = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f)); // You can adjust the direction
-void drawSun(Core::RenderContext& context, glm::mat4 modelMatrix,TextureSet textures) {
-
-	glm::mat4 viewProjectionMatrix = Core::createPerspectiveMatrix(aspectRatio) * Core::createCameraMatrix(cameraDir, cameraPos);
-	glm::mat4 transformation = viewProjectionMatrix * modelMatrix;
-	glUseProgram(programSun);
-
-	glUniform3f(glGetUniformLocation(programSun, "lightDir"), sunDirection.x, sunDirection.y, sunDirection.z);
-	glUniformMatrix4fv(glGetUniformLocation(programSun, "transformation"), 1, GL_FALSE, (float*)&transformation);
-	glUniformMatrix4fv(glGetUniformLocation(programSun, "modelMatrix"), 1, GL_FALSE, (float*)&modelMatrix);
-	glUniform3f(glGetUniformLocation(programSun, "cameraPos"), cameraPos.x, cameraPos.y, cameraPos.z);
-	glUniform3f(glGetUniformLocation(programSun, "lightPos"), 0.0f, 0.0f, 0.0f);
-	Core::SetActiveTexture(textures.albedo, "sunAlbedo", programSun, 0);
-	Core::SetActiveTexture(textures.normal, "sunNormal", programSun, 1);
-	Core::DrawContext(context);
+void drawSun(Core::RenderContext& context, glm::mat4 modelMatrix,int material) {
 
+	submitDraw(Core::PASS_EMISSIVE, uniforms.programSun, context, material, modelMatrix, nullptr);
 }
 
-bool checkCollision(glm::vec3 object1Pos, float object1Radius) {
-	float distance;
-
-	for (const auto& pair : planets.planetsProperties) {
-			distance = glm::length(object1Pos - pair.second.coordinates);
-			if (distance < (object1Radius + pair.second.orbit)) return true;
-		}
-	for (const auto& row : asteroidPositions) {
-		for (const auto& asteroidPos : row) {
-			distance = glm::length(object1Pos - asteroidPos);
-			if (distance < (object1Radius + 1.5f)) return true;
+// Files the bodies, the asteroids, the trash and the checkpoints, in that order, so a query
+// lists them in the order the collision checks them. Their motion is where they are at the
+// time less where they were a step before, taken from the orbits rather than the last step,
+// so the first step after a start or a load does not see everything jump from the origin.
+void updateCollisionWorld(float time, float step) {
+	PROFILE_FUNCTION();
+	float previousTime = time - step;
+	const glm::vec3* bodyPositions = planets.bodies.GetPositions();
+	const glm::vec3* trashPositions = planets.trash.GetPositions();
+	bodyMotion.assign(planets.bodies.GetCount(), glm::vec3(0.f));
+	trashMotion.assign(planets.trash.GetCount(), glm::vec3(0.f));
+	for (int i = 0; i < 8; i++) {
+		const PlanetOrbit& orbit = PLANET_ORBITS[i];
+		glm::vec3 previousPos = planetPosition(orbit, previousTime);
+		int index = planets.bodies.GetIndex(planets.planets[i]);
+		bodyMotion[index] = bodyPositions[index] - previousPos;
+		for (int piece = 0; piece < 4; piece++) {
+			index = planets.trash.GetIndex(planets.trashPieces[i][piece]);
+			trashMotion[index] = trashPositions[index] - trashPosition(previousPos, orbit.trashOrbitRadius, previousTime, piece);
 		}
 	}
-	for ( auto& planetEntry : planets.trashProperties) {
-		const std::string& planetName = planetEntry.first;
-		for ( auto& trashInfo : planetEntry.second) {
-			distance = glm::length(object1Pos - trashInfo.coordinates);
-			if (distance < (object1Radius + trashInfo.orbit)) {
-				trashInfo.destroyed = true;
-				return true;
-			}
-		}
+	placeAsteroids(previousTime, &previousAsteroidPositions, nullptr);
+
+	collisionWorld.Clear();
+	const float* bodyRadii = planets.bodies.GetRadii();
+	for (int i = 0; i < planets.bodies.GetCount(); i++)
+		collisionWorld.Add(bodyPositions[i], bodyRadii[i], LAYER_BODY, i, bodyMotion[i]);
+	int asteroid = 0;
+	for (size_t row = 0; row < asteroidPositions.size(); row++) {
+		for (size_t col = 0; col < asteroidPositions[row].size(); col++)
+			collisionWorld.Add(asteroidPositions[row][col], 1.5f, LAYER_ASTEROID, asteroid++, asteroidPositions[row][col] - previousAsteroidPositions[row][col]);
 	}
-	for (auto& pair : circlePositions) {
-		glm::vec3& position = pair.second.first;
-		bool& visited = pair.second.second;
-		float distance = glm::length(object1Pos - position);
-		if (!visited && distance < (object1Radius + 10.f)) {
+	const float* trashRadii = planets.trash.GetRadii();
+	for (int i = 0; i < planets.trash.GetCount(); i++)
+		collisionWorld.Add(trashPositions[i], trashRadii[i], LAYER_TRASH, i, trashMotion[i]);
+	for (const auto& pair : circlePositions)
+		collisionWorld.Add(pair.second.first, 10.f, LAYER_CHECKPOINT, pair.first);
+	collisionWorld.Build();
+}
+
+bool checkCollision(glm::vec3 object1Pos, float object1Radius, uint32_t layers, float time) {
+	PROFILE_FUNCTION();
+	collisionWorld.Query(object1Pos, object1Radius, layers, collisionCandidates);
+	uint32_t* trashFlags = planets.trash.GetFlags();
+	for (int candidate : collisionCandidates) {
+		const Core::BroadphaseProxy& proxy = collisionWorld.GetProxy(candidate);
+		if (proxy.layers & (LAYER_BODY | LAYER_ASTEROID)) return true;
+		if (proxy.layers & LAYER_TRASH) {
+			trashFlags[proxy.id] |= Core::ENTITY_HIT;
+			return true;
+		}
+
+		bool& visited = circlePositions[proxy.id].second;
+		if (!visited) {
 			visited = true;
 			circleVisited++;
-			if (circleVisited == 1) start_time = std::chrono::steady_clock::now();
+			if (circleVisited == 1) raceStartTime = time;
 			if (circleVisited == 8) {
-				end_time = std::chrono::steady_clock::now();
-				std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-				if (elapsed_seconds.count() < 15.0) {
+				if (time - raceStartTime < RACE_TIME_LIMIT) {
 					raceCompleted = true;
-					renderSprite->UpdateSprite(sprites.sprite_3);
 					std::cout << "skonczyles wyscig";
 				}
 				else
@@ -308,330 +456,747 @@ bool checkCollision(glm::vec3 object1Pos, float object1Radius) {
 	return false;
 }
 
-void renderScene(GLFWwindow* window)
-{
-	glClearColor(0.0f, 0.0f, 0.15f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// Collision of a projectile that moved from start to end over the step, against the world
+// moving over the same step; it stops at whichever body, asteroid or trash it meets first.
+bool checkSweptCollision(const glm::vec3& start, const glm::vec3& end, float radius, uint32_t layers) {
+	PROFILE_FUNCTION();
+	Core::SweptSphere sweep = { start, end, radius, layers & ~LAYER_CHECKPOINT };
+	Core::SweptHit hit;
+	collisionWorld.QuerySwept(&sweep, 1, &hit);
+	if (hit.proxy < 0)
+		return false;
+
+	const Core::BroadphaseProxy& proxy = collisionWorld.GetProxy(hit.proxy);
+	if (proxy.layers & LAYER_TRASH)
+		planets.trash.GetFlags()[proxy.id] |= Core::ENTITY_HIT;
+	return true;
+}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// Sizes the targets from the framebuffer and the render scale. The graph allocates them
+// as the frame declares them, so a new size or profile needs nothing else.
+void updateRenderSize() {
+	const Core::RenderTargetFormats& formats = Core::GetRenderTargetFormats(renderTargetProfile);
+	int width = std::max(1, (int)(framebufferWidth * dynamicResolution.GetScale()));
+	int height = std::max(1, (int)(framebufferHeight * dynamicResolution.GetScale()));
+	brightWidth = std::max(1, width / formats.brightDownscale);
+	brightHeight = std::max(1, height / formats.brightDownscale);
+	if (width == renderWidth && height == renderHeight)
+		return;
 
-	glm::mat4 transformation;
-	float time = glfwGetTime();
-	updateDeltaTime(time);
+	renderWidth = width;
+	renderHeight = height;
+	renderGraph.RequestReport();
+	std::cout << "render targets: " << width << "x" << height << " (scale " << dynamicResolution.GetScale() << ")" << std::endl;
+}
 
-	Core::DrawSkybox(programSkybox, contexts.skyboxContext, skyboxTexture, cameraDir, cameraPos, aspectRatio);
-	glClear(GL_DEPTH_BUFFER_BIT);
+void reportBloomCost() {
+	// the bright pass reads the whole scene once and writes the smaller buffer
+	const Core::RenderTargetFormats& formats = Core::GetRenderTargetFormats(renderTargetProfile);
+	size_t brightBytes = (size_t)brightWidth * brightHeight * formats.bloomColor.bytesPerTexel;
+	size_t sceneBytes = (size_t)renderWidth * renderHeight * formats.sceneColor.bytesPerTexel;
+	std::vector<Core::BloomPassCost> passes;
+	passes.push_back({ "bright pass", brightWidth, brightHeight, 4, sceneBytes + brightBytes });
+	if (bloomMode == BLOOM_PYRAMID)
+	{
+		std::vector<Core::BloomPassCost> pyramidPasses = bloomPyramid.GetPassCosts(brightWidth, brightHeight, formats.bloomColor);
+		passes.insert(passes.end(), pyramidPasses.begin(), pyramidPasses.end());
+	}
+	else
+	{
+		// every pass reads one ping-pong buffer and writes the other
+		for (unsigned int i = 0; i < GAUSSIAN_BLUR_PASSES; i++)
+			passes.push_back({ i % 2 == 0 ? "gaussian horizontal" : "gaussian vertical", brightWidth, brightHeight, 9, 2 * brightBytes });
+	}
 
-	glm::vec3 sunPosition = glm::vec3(0, 0, 0);
-	planets.planetsProperties["Sun"] = { sunPosition, 30.f };
-	drawSun(contexts.sphereContext, glm::scale(glm::vec3(30.f)) * glm::translate(sunPosition), textures.sun);
+	size_t totalPixels = 0, totalTaps = 0, totalBytes = 0;
+	std::cout << "bloom " << (bloomMode == BLOOM_PYRAMID ? "pyramid" : "gaussian") << " passes:" << std::endl;
+	for (const Core::BloomPassCost& pass : passes)
+	{
+		size_t pixels = (size_t)pass.width * pass.height;
+		std::cout << "  " << pass.name << " " << pass.width << "x" << pass.height << ": "
+			<< pixels / 1e6f << " Mpx, " << pixels * pass.taps / 1e6f << " M taps, " << pass.bytes / (1024.f * 1024.f) << " MB" << std::endl;
+		totalPixels += pixels;
+		totalTaps += pixels * pass.taps;
+		totalBytes += pass.bytes;
+	}
+	std::cout << "  total " << passes.size() << " passes: " << totalPixels / 1e6f << " Mpx, " << totalTaps / 1e6f << " M taps, "
+		<< totalBytes / (1024.f * 1024.f) << " MB per frame" << std::endl;
+}
 
-	drawPlanet(contexts.sphereContext, textures.planets.mercury, 15.0f * 5, 0.2f, time, glm::vec3(0.5 * 9), 1 * 9, std::string("Mercury"));
-	drawPlanet(contexts.sphereContext, textures.planets.venus, 20.0f * 5, 0.175f, time, glm::vec3(1.f * 9), 1.5 * 9, std::string("Venus"));
-	drawPlanet(contexts.sphereContext, textures.planets.earth, 25.0f * 5, 0.15f, time, glm::vec3(1.3f * 9), 2 * 9, std::string("Earth"));
-	drawPlanet(contexts.sphereContext, textures.planets.mars, 30.0f * 5, 0.125f, time, glm::vec3(1.3f * 9), 2 * 9, std::string("Mars"));
-	drawPlanet(contexts.sphereContext, textures.planets.jupiter, 40.0f * 5, 0.1f, time, glm::vec3(2.5f * 9), 3 * 9, std::string("Jupiter"));
-	drawPlanet(contexts.sphereContext, textures.planets.saturn, 50.0f * 5, 0.075f, time, glm::vec3(2.2f * 9), 3 * 9, std::string("Saturn"));
-	drawPlanet(contexts.sphereContext, textures.planets.uran, 55.0f * 5, 0.05f, time, glm::vec3(1.6f * 9), 2.5 * 9, std::string("Uran"));
-	drawPlanet(contexts.sphereContext, textures.planets.neptune, 60.0f * 5, 0.025f, time, glm::vec3(1.8f * 9), 2.5 * 9, std::string("Neptun"));
+Core::GraphResource addBrightPass(Core::RenderGraph& graph, Core::GraphResource scene) {
+	Core::RenderPassBuilder pass = graph.AddPass("bright pass");
+	pass.Read(scene);
+	Core::GraphResource bright = pass.Create("bright", { brightWidth, brightHeight, Core::GetRenderTargetFormats(renderTargetProfile).bloomColor });
+	float downscale = (float)renderWidth / brightWidth;
+	bool alphaThreshold = Core::GetRenderTargetFormats(renderTargetProfile).sceneColor.hasAlpha;
+	pass.Execute([=](const Core::RenderGraph& graph) {
+		Core::UseProgram(programBrightPass);
+		Core::SetActiveTexture(graph.GetTexture(scene), uniforms.programBrightPass.scene);
+		glUniform1f(uniforms.programBrightPass.downscale.location, downscale);
+		glUniform1f(uniforms.programBrightPass.threshold.location, alphaThreshold ? -1.f : GLOBAL_BLOOM_THRESHOLD);
+		Core::DrawScreenQuad();
+	});
+	return bright;
+}
 
-	glm::vec3 initialAsteroidPosition(0.f, 40.f, 0.f);
-	float offset = sin(time) * 2.0f;
+// Every pass writes a new transient; the graph places them in two alternating textures.
+Core::GraphResource addGaussianBloomPasses(Core::RenderGraph& graph, Core::GraphResource bright) {
+	Core::GraphResource source = bright;
+	for (unsigned int i = 0; i < GAUSSIAN_BLUR_PASSES; i++)
+	{
+		bool horizontal = i % 2 == 0;
+		Core::RenderPassBuilder pass = graph.AddPass(horizontal ? "gaussian horizontal" : "gaussian vertical");
+		pass.Read(source);
+		Core::GraphResource target = pass.Create("gaussian " + std::to_string(i), graph.GetDesc(bright));
+		pass.Execute([=](const Core::RenderGraph& graph) {
+			Core::UseProgram(programBlur);
+			glUniform1i(uniforms.programBlur.horizontal.location, horizontal);
+			Core::SetActiveTexture(graph.GetTexture(source), uniforms.programBlur.image);
+			Core::DrawScreenQuad();
+		});
+		source = target;
+	}
+	return source;
+}
 
-	std::default_random_engine generator; // Inicjalizacja generatora liczb losowych
-	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f); // Zakres losowych wartoci od -1.0 do 1.0
+// What the renderer interpolates between two steps.
+struct SimulationSnapshot
+{
+	glm::vec3 spaceshipPos;
+	glm::vec3 spaceshipDir;
+	glm::vec3 laserPosition;
+	bool laserActive;
+};
 
-	for (int row = 0; row < 3; ++row)
+Core::FixedTimestep fixedTimestep;
+bool simulationStarted = false;
+// game time of the current snapshot
+double simulationTime = 0.0;
+SimulationSnapshot previousSnapshot;
+SimulationSnapshot currentSnapshot;
+// input of the frame the simulation thread is running
+Core::FrameInput simulationInput;
+std::atomic<int> simulationSteps(0);
+
+// Everything the render thread draws from, published whole by the simulation thread after
+// the steps of each input frame. The render thread never reads the game state itself.
+struct SceneSnapshot
+{
+	// input frames simulated into it; 0 before the first
+	int frame;
+	SimulationSnapshot previous;
+	SimulationSnapshot current;
+	// game time of current, and how far the input frame was past it in steps
+	double time;
+	float alpha;
+	bool trashVisible[8][4];
+	bool circleVisited[8];
+	int trashDestroyed;
+	bool hideInstruction;
+	bool showMissions;
+	bool raceCompleted;
+	bool trashCompleted;
+};
+
+// Frames of input the simulation may fall behind by before the render thread waits for it.
+const size_t INPUT_QUEUE_SIZE = 64;
+Core::SpscQueue<Core::FrameInput, INPUT_QUEUE_SIZE> inputQueue;
+Core::TripleBuffer<SceneSnapshot> sceneSnapshots;
+std::thread simulationThread;
+std::atomic<bool> simulationRunning(false);
+// input frames handed over by the render thread, and simulated by the simulation thread
+int submittedFrames = 0;
+int simulatedFrames = 0;
+
+SimulationSnapshot takeSnapshot() {
+	return { spaceshipPos, spaceshipDir, laser.position, laser.isActive };
+}
+
+SimulationSnapshot interpolateSnapshots(const SimulationSnapshot& from, const SimulationSnapshot& to, float alpha) {
+	SimulationSnapshot snapshot;
+	snapshot.spaceshipPos = glm::mix(from.spaceshipPos, to.spaceshipPos, alpha);
+	snapshot.spaceshipDir = glm::normalize(glm::mix(from.spaceshipDir, to.spaceshipDir, alpha));
+	// a shot fired in the last step starts where it is, not between the ship and the old shot
+	snapshot.laserActive = to.laserActive;
+	snapshot.laserPosition = from.laserActive ? glm::mix(from.laserPosition, to.laserPosition, alpha) : to.laserPosition;
+	return snapshot;
+}
+
+// One fixed step of the game at the given time: the world moves to it, then the ship and
+// the laser move and collide with it.
+void stepSimulation(float time, float step) {
+	for (int i = 0; i < 8; i++)
+		updatePlanet(i, time);
+	placeAsteroids(time, &asteroidPositions, nullptr);
+	updateCollisionWorld(time, step);
+
+	if (benchmark.enabled && !inputReplay.IsOpen())
+		Core::SampleBenchmarkPath(time, spaceshipPos, spaceshipDir);
+	else
 	{
-		for (int col = 0; col < 8; ++col)
+		float moveSpeed = 0.6f * step * 60;
+		glm::vec3 newSpaceshipPos = spaceshipPos;
+		if (hideInstruction == true) {
+			if (simulationInput.IsDown(Core::INPUT_KEY_W)) newSpaceshipPos += spaceshipDir * moveSpeed;
+			if (simulationInput.IsDown(Core::INPUT_KEY_S)) newSpaceshipPos -= spaceshipDir * moveSpeed;
+		}
+		if (checkCollision(newSpaceshipPos, spaceshipRadius, LAYER_SHIP_HITS, time) == false) spaceshipPos = newSpaceshipPos;
+
+		// the ship turns towards the mouse heading as fast per second as it did at 60 frames per second
+		float turn = 1.f - std::pow(0.9f, step * 60.f);
+		glm::quat spaceshipRotation = glm::quat(glm::vec3(glm::radians(spaceshipUp), glm::radians(-spaceshipSide), 0.0f));
+		spaceshipDir = glm::lerp(spaceshipDir, glm::rotate(spaceshipRotation, glm::vec3(0.0f, 0.0f, -1.0f)), turn);
+	}
+
+	if (laser.isActive)
+	{
+		if (time - laser.startTime < laser.duration)
 		{
-			glm::vec3 position = initialAsteroidPosition + glm::vec3(col * 10.f, 0.f, row * 10.f);
-			if (row % 2 == 1) position.x += 10.f * 0.5f;
-			position.x += offset;
+			float laserSpeed = 150.f;
+			glm::vec3 laserStart = laser.position;
+			laser.position += laser.direction * laserSpeed * step;
+			if (checkSweptCollision(laserStart, laser.position, 0.5f, LAYER_LASER_HITS)) laser.isActive = false;
+		}
+		else laser.isActive = false;
+	}
 
-			position.x += distribution(generator) * 5.f;
-			position.y += distribution(generator) * 5.f;
-			position.z += distribution(generator) * 5.f;
+	if (trashDestroyed == 10)
+		trashCompleted = true;
+}
 
-			asteroidPositions[row][col] = position;
+// The game's part of a frame's input: the instruction and mission screens, the laser and
+// the mouse heading. Movement and turning happen in the steps.
+void applyFrameInput(const Core::FrameInput& input) {
+	if (input.IsDown(Core::INPUT_KEY_X)) hideInstruction = true;
+	if (hideInstruction == true) {
+		showMissions = input.IsDown(Core::INPUT_KEY_TAB);
+		if (input.IsDown(Core::INPUT_KEY_SPACE) && !laser.isActive)
+		{
+			laser.isActive = true;
+			laser.position = spaceshipPos;
+			laser.direction = spaceshipDir;
+			laser.startTime = (float)simulationTime;
+		}
+	}
+
+	float mouseSensitivity = 0.1f;
+
+	cameraSide += input.mouseDeltaX * mouseSensitivity;
+	cameraUp -= input.mouseDeltaY * mouseSensitivity;
 
-			transformation = glm::translate(glm::mat4(1.0f), position) *
-				glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) *
-				glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f));
+	spaceshipSide += input.mouseDeltaX * mouseSensitivity;
+	spaceshipUp -= input.mouseDeltaY * mouseSensitivity;
+
+	cameraUp = glm::clamp(cameraUp, -89.0f, 89.0f);
+	spaceshipUp = glm::clamp(cameraUp, -89.0f, 89.0f);
+}
 
-			drawObjectTexture(programDefault, contexts.asteroidContext, textures.asteroid, transformation);
+// Runs the steps the time of this frame's input covers.
+void advanceSimulation() {
+	int steps = fixedTimestep.Advance(simulationInput.time);
+	if (!simulationStarted)
+	{
+		simulationStarted = true;
+		simulationTime = simulationInput.time;
+		previousSnapshot = currentSnapshot = takeSnapshot();
+	}
+	for (int i = 0; i < steps; i++)
+	{
+		previousSnapshot = currentSnapshot;
+		simulationTime += fixedTimestep.GetStep();
+		stepSimulation((float)simulationTime, fixedTimestep.GetStep());
+		currentSnapshot = takeSnapshot();
+	}
+	simulationSteps += steps;
+}
+
+void publishSceneSnapshot() {
+	SceneSnapshot& scene = sceneSnapshots.GetWriteSlot();
+	scene.frame = simulatedFrames;
+	scene.previous = previousSnapshot;
+	scene.current = currentSnapshot;
+	scene.time = simulationTime;
+	scene.alpha = fixedTimestep.GetAlpha();
+	for (int i = 0; i < 8; i++)
+	{
+		for (int piece = 0; piece < 4; piece++)
+			scene.trashVisible[i][piece] = (planets.trash.GetFlags()[planets.trash.GetIndex(planets.trashPieces[i][piece])] & Core::ENTITY_VISIBLE) != 0;
+	}
+	int circle = 0;
+	for (const auto& pair : circlePositions)
+		scene.circleVisited[circle++] = pair.second.second;
+	scene.trashDestroyed = trashDestroyed;
+	scene.hideInstruction = hideInstruction;
+	scene.showMissions = showMissions;
+	scene.raceCompleted = raceCompleted;
+	scene.trashCompleted = trashCompleted;
+	sceneSnapshots.Publish();
+}
+
+// One input frame on the simulation thread: its input, the steps its time covers and the
+// snapshot of the result.
+void simulateFrame(const Core::FrameInput& input) {
+	PROFILE_FUNCTION();
+	simulationInput = input;
+	// the benchmark path flies the ship by itself, past the instruction screen
+	if (benchmark.enabled && !inputReplay.IsOpen())
+		hideInstruction = true;
+	else
+		applyFrameInput(input);
+	advanceSimulation();
+	simulatedFrames++;
+	publishSceneSnapshot();
+}
+
+// Runs every frame of input in order, so a replay steps exactly as its recording did, and
+// exits once the render thread has stopped it and the queue is empty.
+void simulationLoop() {
+	Core::FrameInput input;
+	int idleSpins = 0;
+	while (true)
+	{
+		// read before the pop: once stopped, an empty queue stays empty
+		bool running = simulationRunning.load(std::memory_order_acquire);
+		if (inputQueue.Pop(input))
+		{
+			simulateFrame(input);
+			idleSpins = 0;
+			continue;
 		}
+		if (!running)
+			break;
+		if (++idleSpins < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
 	}
+}
 
-	glm::vec3 position;
+// The first snapshot is the state after loading, so the render thread has one to draw
+// before the simulation thread publishes.
+void startSimulationThread() {
+	previousSnapshot = currentSnapshot = takeSnapshot();
+	publishSceneSnapshot();
+	simulationRunning = true;
+	simulationThread = std::thread(simulationLoop);
+}
 
-	position = glm::vec3(-58.f + 3 * sin(time*2), -50.f, -8.f);
-	position.z += 15.f * cos(time*2);
-	transformation = glm::translate(position) * glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f))*glm::scale(glm::vec3(2.f));
-	drawObjectTexture(programDefault, contexts.asteroidContext, textures.asteroid, transformation);
-	asteroidPositions[3][0] = position;
+void stopSimulationThread() {
+	simulationRunning.store(false, std::memory_order_release);
+	if (simulationThread.joinable())
+		simulationThread.join();
+}
 
-	position = glm::vec3(58.f + 3 * sin(time * 2), -50.f, -8.f);
-	position.z += 15.f * cos(time * 2);
-	transformation = glm::translate(position) * glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(2.f));
-	drawObjectTexture(programDefault, contexts.asteroidContext, textures.asteroid, transformation);
-	asteroidPositions[3][1] = position;
+// Hands this frame's input to the simulation thread, waiting while it is a full queue behind.
+// Returns the frame's number, the one its snapshot will carry.
+int submitFrameInput() {
+	while (!inputQueue.Push(frameInput))
+		std::this_thread::yield();
+	return ++submittedFrames;
+}
 
-	position = glm::vec3(-8.f, -50.f, 58.f + 3 * sin(time * 2));
-	position.x += 15.f * cos(time * 2);
-	transformation = glm::translate(position) * glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(2.f));
-	drawObjectTexture(programDefault, contexts.asteroidContext, textures.asteroid, transformation);
-	asteroidPositions[3][2] = position;
+// Snapshot to draw after submitting the given frame. Play draws the latest one, usually of the
+// frame before, while this frame simulates. The benchmark and replays wait for the frame's own
+// snapshot, so every run draws the same scenes and counts the same draws.
+const SceneSnapshot& readSceneSnapshot(int frame) {
+	PROFILE_FUNCTION();
+	bool lockstep = benchmark.enabled || inputReplay.IsOpen();
+	const SceneSnapshot* scene = &sceneSnapshots.Read();
+	while (lockstep && scene->frame < frame)
+	{
+		std::this_thread::yield();
+		scene = &sceneSnapshots.Read();
+	}
+	return *scene;
+}
+
+void reportRenderStats(float time) {
+	if (time - lastStatsReportTime < STATS_REPORT_INTERVAL) return;
+	lastStatsReportTime = time;
+
+	const Core::RenderQueueStats& stats = renderQueue.GetStats();
+	std::cout << "render queue: " << stats.items << " items, "
+		<< "program binds " << stats.programBinds << " (skipped " << stats.programBindsSkipped << "), "
+		<< "vertex array binds " << stats.vertexArrayBinds << " (skipped " << stats.vertexArrayBindsSkipped << "), "
+		<< "material switches " << stats.materialSwitches << " (skipped " << stats.materialSwitchesSkipped << "), "
+		<< stats.drawCalls << " draw calls for " << stats.multiDrawCommands << " indirect commands and " << stats.instances << " instances, "
+		<< "objects drawn " << stats.objectsDrawn << " (culled " << stats.objectsCulled << "), "
+		<< "lod objects " << stats.lodObjects[0] << "/" << stats.lodObjects[1] << "/" << stats.lodObjects[2] << "/" << stats.lodObjects[3] << ", "
+		<< stats.triangles << " triangles of " << stats.fullDetailTriangles << " at full detail" << std::endl;
+
+	std::cout << "render scale " << dynamicResolution.GetScale() << " (" << renderWidth << "x" << renderHeight << " of "
+		<< framebufferWidth << "x" << framebufferHeight << "), gpu frame " << dynamicResolution.GetAverageFrameTime() * 1000.f << " ms" << std::endl;
+
+	std::cout << "simulation: " << simulationSteps.exchange(0) << " steps of " << fixedTimestep.GetStep() * 1000.f << " ms since the last report" << std::endl;
+
+	const Core::RenderGraphStats& graphStats = renderGraph.GetStats();
+	std::cout << "gpu passes (min/avg/p99 ms):";
+	for (const Core::GpuPassTiming& timing : gpuProfiler.GetTimings())
+		std::cout << " " << timing.name << " " << timing.min << "/" << timing.average << "/" << timing.p99 << ";";
+	std::cout << std::endl;
+
+	std::cout << "render graph: " << graphStats.passes << " passes (culled " << graphStats.passesCulled << "), "
+		<< graphStats.textures << " transients in " << graphStats.physicalTextures << " textures, "
+		<< graphStats.textureBytes / (1024.f * 1024.f) << " MB placed in " << graphStats.physicalBytes / (1024.f * 1024.f) << " MB, "
+		<< "pool " << graphStats.pooledBytes / (1024.f * 1024.f) << " MB" << std::endl;
+
+	const Core::RenderStateCounters& counters = Core::GetRenderStateCounters();
+	const char* names[Core::STATE_CALL_COUNT] = { "program", "vertex array", "active texture", "texture", "framebuffer", "enable" };
+	std::cout << "gl state: " << counters.TotalIssued() << " issued, " << counters.TotalFiltered() << " filtered (";
+	for (int i = 0; i < Core::STATE_CALL_COUNT; i++)
+		std::cout << (i > 0 ? ", " : "") << names[i] << " " << counters.issued[i] << "/" << counters.filtered[i];
+	std::cout << ")" << std::endl;
+}
+
+// Draws the scene snapshot; runs alongside the simulation of the next frames.
+void renderScene(GLFWwindow* window, const SceneSnapshot& scene)
+{
+	PROFILE_FUNCTION();
+	Core::ResetRenderStateCounters();
+	gpuProfiler.Collect();
+	gpuProfiler.BeginFrame();
+
+	// the scale follows the GPU time of frames a few frames back
+	float gpuFrameTime;
+	while (gpuProfiler.ReadFrameTime(gpuFrameTime))
+	{
+		if (dynamicResolution.Update(gpuFrameTime))
+			updateRenderSize();
+		if (benchmarkMeasuring)
+			benchmarkRecorder.AddGpuFrame(gpuFrameTime);
+	}
 
-	position = glm::vec3(-8.f, -50.f, -58.f + 3 * sin(time * 2));
-	position.x += 15.f * cos(time * 2);
-	transformation = glm::translate(position) * glm::rotate(2.f * time, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::rotate(0.5f * time, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(2.f));
-	drawObjectTexture(programDefault, contexts.asteroidContext, textures.asteroid, transformation);
-	asteroidPositions[3][3] = position;
+	float time = frameInput.time;
+	// the world is drawn between the last two steps, as far as the frame is past the older one
+	float renderTime = (float)(scene.time - (1.0 - scene.alpha) * fixedTimestep.GetStep());
+	SimulationSnapshot view = interpolateSnapshots(scene.previous, scene.current, scene.alpha);
+
+	cameraPos = view.spaceshipPos - 1.5f * view.spaceshipDir + glm::vec3(0, 1, 0) * 0.5f;
+	cameraDir = view.spaceshipDir;
+	spotlightPos = view.spaceshipPos + 0.2f * view.spaceshipDir;
+	spotlightConeDir = view.spaceshipDir;
+
+	glm::mat4 transformation;
+	updateFrameUniforms();
+	instanceBatches.clear();
+
+	drawSun(contexts.sphereContext, glm::scale(glm::vec3(30.f)) * glm::translate(SUN_POSITION), materials.sun);
+
+	const int planetMaterials[8] = {
+		materials.planets.mercury, materials.planets.venus, materials.planets.earth, materials.planets.mars,
+		materials.planets.jupiter, materials.planets.saturn, materials.planets.uran, materials.planets.neptune
+	};
+	// planets, their trash and the asteroids go into one batch and are composed together
+	sceneTransforms.Resize(8 * PLANET_TRANSFORMS);
+	for (int i = 0; i < 8; i++)
+		setPlanetTransforms(PLANET_ORBITS[i], renderTime, sceneTransforms, i * PLANET_TRANSFORMS);
+	placeAsteroids(renderTime, nullptr, &sceneTransforms);
+	sceneMatrices.resize(sceneTransforms.GetCount());
+	jobSystem.ParallelFor(sceneTransforms.GetCount(), TRANSFORMS_PER_JOB, [](int begin, int end) {
+		Core::ComposeTransforms(sceneTransforms, begin, end, sceneMatrices.data());
+	});
+
+	for (int i = 0; i < 8; i++)
+		drawPlanet(contexts.sphereContext, planetMaterials[i], &sceneMatrices[i * PLANET_TRANSFORMS], scene.trashVisible[i]);
+	instanceBatches.asteroids.assign(sceneMatrices.begin() + 8 * PLANET_TRANSFORMS, sceneMatrices.end());
 
 	transformation = glm::translate(glm::vec3(0.f, -50.f, 0.f))*glm::scale( glm::vec3(50.f))* glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f));
-	drawObjectTexture(programDefault, contexts.barierContext, textures.barier, transformation);
+	instanceBatches.bariers.push_back(transformation);
 	transformation = glm::translate(glm::vec3(0.f, -50.f, 0.f)) * glm::scale(glm::vec3(70.f)) * glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f));
-	drawObjectTexture(programDefault, contexts.barierContext, textures.barier, transformation);
-
-	TextureSet texture;
-	bool visited;
+	instanceBatches.bariers.push_back(transformation);
 
 	auto it = circlePositions.begin();
-	for (int i = 0; i < 4; ++i, ++it) {
+	int circle = 0;
+	for (; circle < 4; ++circle, ++it) {
 		const glm::vec3& pos = it->second.first;
-		bool visited = it->second.second;
-		if (visited) texture = textures.circle_dark; else texture = textures.circle_bright;
-		drawObjectTexture(programDefault, contexts.circleContext, texture,
-			glm::translate(pos) * glm::scale(glm::vec3(15.f)) * glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f)));
+		bool visited = scene.circleVisited[circle];
+		std::vector<glm::mat4>& batch = visited ? instanceBatches.circlesDark : instanceBatches.circlesBright;
+		batch.push_back(glm::translate(pos) * glm::scale(glm::vec3(15.f)) * glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f)));
 	}
 
-	for (; it != circlePositions.end(); ++it) {
+	for (; it != circlePositions.end(); ++circle, ++it) {
 		const glm::vec3& pos = it->second.first;
-		bool visited = it->second.second;
-		if (visited) texture = textures.circle_dark; else texture = textures.circle_bright;
-		drawObjectTexture(programDefault, contexts.circleContext, texture,
-			glm::translate(pos) * glm::scale(glm::vec3(15.f)) * glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f)) * glm::rotate(glm::radians(90.f), glm::vec3(0.f, 0.f, 1.0f)));
+		bool visited = scene.circleVisited[circle];
+		std::vector<glm::mat4>& batch = visited ? instanceBatches.circlesDark : instanceBatches.circlesBright;
+		batch.push_back(glm::translate(pos) * glm::scale(glm::vec3(15.f)) * glm::rotate(glm::radians(270.f), glm::vec3(1.0f, 0.f, 0.0f)) * glm::rotate(glm::radians(90.f), glm::vec3(0.f, 0.f, 1.0f)));
 	}
 
-	glm::vec3 spaceshipSide = glm::normalize(glm::cross(spaceshipDir, glm::vec3(0.f, 1.f, 0.f)));
-	glm::vec3 spaceshipUp = glm::normalize(glm::cross(spaceshipSide, spaceshipDir));
+	drawObjectInstanced(contexts.asteroidContext, materials.asteroid, instanceBatches.asteroids);
+	drawObjectInstanced(contexts.trash1Context, materials.trash1, instanceBatches.trash1);
+	drawObjectInstanced(contexts.trash2Context, materials.trash2, instanceBatches.trash2);
+	drawObjectInstanced(contexts.barierContext, materials.barier, instanceBatches.bariers);
+	drawObjectInstanced(contexts.circleContext, materials.circle_bright, instanceBatches.circlesBright);
+	drawObjectInstanced(contexts.circleContext, materials.circle_dark, instanceBatches.circlesDark);
+
+	glm::vec3 spaceshipSide = glm::normalize(glm::cross(view.spaceshipDir, glm::vec3(0.f, 1.f, 0.f)));
+	glm::vec3 spaceshipUp = glm::normalize(glm::cross(spaceshipSide, view.spaceshipDir));
 	glm::mat4 spaceshipCameraRotationMatrix = glm::mat4({
 		spaceshipSide.x,spaceshipSide.y,spaceshipSide.z,0,
 		spaceshipUp.x,spaceshipUp.y,spaceshipUp.z ,0,
-		-spaceshipDir.x,-spaceshipDir.y,-spaceshipDir.z,0,
+		-view.spaceshipDir.x,-view.spaceshipDir.y,-view.spaceshipDir.z,0,
 		0.,0.,0.,1.,
 		});
-	drawObjectTexture(programDefault, contexts.shipContext, textures.spaceship, glm::translate(spaceshipPos) * spaceshipCameraRotationMatrix * glm::eulerAngleY(glm::pi<float>()) * glm::scale(glm::vec3(0.0004)));
+	drawObjectTexture(contexts.shipContext, materials.spaceship, glm::translate(view.spaceshipPos) * spaceshipCameraRotationMatrix * glm::eulerAngleY(glm::pi<float>()) * glm::scale(glm::vec3(0.0004)));
 
-	if (laser.isActive)
+	if (view.laserActive)
 	{
-		float currentTime = glfwGetTime();
-		float elapsedTime = currentTime - laser.startTime;
-
-		if (elapsedTime < laser.duration)
-		{
-			float laserSpeed = 150.f;
-			laser.position += laser.direction * laserSpeed * deltaTime;
-
-			glm::mat4 laserModelMatrix = glm::translate(laser.position) * glm::scale(glm::vec3(0.0003));
-			drawSun(contexts.laserContext, laserModelMatrix, textures.laser); 
-			if(checkCollision(laser.position,0.5f)) laser.isActive = false;
-		}
-		else laser.isActive = false;
+		glm::mat4 laserModelMatrix = glm::translate(view.laserPosition) * glm::scale(glm::vec3(0.0003));
+		drawSun(contexts.laserContext, laserModelMatrix, materials.laser);
 	}
 
-	if (!hideInstruction)
-	{
-		renderSpriteStart->DrawSprite(programSprite, 740.0f, 880.0f);
-	}
-
-	if (showMissions)
-	{
-		renderSprite->DrawSprite(programSprite, 740.0f, 580.0f);
-	}
-
-	if (trashDestroyed == 10)
-	{
+	// the mission sprite changes here, the simulation thread has no GL context
+	if (scene.trashCompleted && scene.raceCompleted)
+		renderSprite->UpdateSprite(sprites.sprite_4);
+	else if (scene.trashCompleted)
 		renderSprite->UpdateSprite(sprites.sprite_2);
-		trashCompleted = true;
-	}
-	if (trashCompleted && raceCompleted)
+	else if (scene.raceCompleted)
+		renderSprite->UpdateSprite(sprites.sprite_3);
+
+	const Core::RenderTargetFormats& formats = Core::GetRenderTargetFormats(renderTargetProfile);
+	Core::GraphResource backbuffer = renderGraph.ImportBackbuffer(framebufferWidth, framebufferHeight);
+
+	Core::RenderPassBuilder skyboxPass = renderGraph.AddPass("skybox");
+	Core::GraphResource sceneColor = skyboxPass.Create("scene color", { renderWidth, renderHeight, formats.sceneColor });
+	skyboxPass.Execute([](const Core::RenderGraph&) {
+		glClearColor(0.0f, 0.0f, 0.15f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		Core::DrawSkybox(programSkybox, contexts.skyboxContext, skyboxTexture);
+	});
+
+	// the scene writes one attachment; its alpha holds the bloom threshold of the pixel
+	Core::RenderPassBuilder scenePass = renderGraph.AddPass("scene");
+	scenePass.Write(sceneColor);
+	scenePass.Create("scene depth", { renderWidth, renderHeight, formats.sceneDepth });
+	scenePass.Execute([&scene](const Core::RenderGraph&) {
+		glClear(GL_DEPTH_BUFFER_BIT);
+		renderQueue.Flush(materialLibrary, cameraView, jobSystem);
+
+		if (!scene.hideInstruction)
+			renderSpriteStart->DrawSprite(740.0f, 880.0f);
+		if (scene.showMissions)
+			renderSprite->DrawSprite(740.0f, 580.0f);
+		if (scene.trashCompleted && scene.raceCompleted)
+			renderSpriteEnd->DrawSprite(740.0f, 580.0f);
+	});
+
+	// both bloom paths are declared; the graph culls the one the composite does not read
+	Core::GraphResource bright = addBrightPass(renderGraph, sceneColor);
+	Core::GraphResource gaussianBloom = addGaussianBloomPasses(renderGraph, bright);
+	Core::GraphResource pyramidBloom = bloomPyramid.AddPasses(renderGraph, bright);
+	Core::GraphResource bloom = bloomMode == BLOOM_PYRAMID ? pyramidBloom : gaussianBloom;
+
+	Core::RenderPassBuilder compositePass = renderGraph.AddPass("composite");
+	compositePass.Read(sceneColor);
+	compositePass.Read(bloom);
+	compositePass.Write(backbuffer);
+	bool upscale = renderWidth < framebufferWidth;
+	compositePass.Execute([=](const Core::RenderGraph& graph) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		Core::UseProgram(programBloomFinal);
+		Core::SetActiveTexture(graph.GetTexture(sceneColor), uniforms.programBloomFinal.scene);
+		Core::SetActiveTexture(graph.GetTexture(bloom), uniforms.programBloomFinal.bloomBlur);
+		glUniform1i(uniforms.programBloomFinal.bloom.location, true);
+		glUniform1f(uniforms.programBloomFinal.exposure.location, exposure);
+		glUniform1i(uniforms.programBloomFinal.upscale.location, upscale);
+		Core::DrawScreenQuad();
+	});
+
 	{
-		renderSprite->UpdateSprite(sprites.sprite_4);
-		renderSpriteEnd->DrawSprite(programSprite, 740.0f, 580.0f);
+		PROFILE_ZONE("renderGraph.Execute");
+		renderGraph.Execute();
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	bool horizontal = true, first_iteration = true;
-	unsigned int amount = 20;
-	glUseProgram(programBlur);
-	for (unsigned int i = 0; i < amount; i++)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-		glUniform1i(glGetUniformLocation(programBlur, "horizontal"), horizontal);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
-		renderQuad();
-		horizontal = !horizontal;
-		if (first_iteration)
-			first_iteration = false;
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glUseProgram(programBloomFinal);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-	glUniform1i(glGetUniformLocation(programBloomFinal, "bloom"), true);
-	glUniform1f(glGetUniformLocation(programBloomFinal, "exposure"), exposure);
-	renderQuad();
-
-	glUseProgram(0);
+	reportRenderStats(time);
+	gpuProfiler.EndFrame();
 	glfwSwapBuffers(window);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-	aspectRatio = 1920 /float(1080);
+	// a minimized window reports a zero size
+	if (width == 0 || height == 0)
+		return;
+	framebufferWidth = width;
+	framebufferHeight = height;
+	aspectRatio = width / float(height);
 	glViewport(0, 0, width, height);
-	std::cout << width << height;
+	updateRenderSize();
 }
 
-TextureSet loadTextureSet(const std::string& albedoPath, const std::string& normalPath, const std::string& aoPath, const std::string& roughnessPath, const std::string& metallicPath) {
-	TextureSet textureSet;
-	textureSet.albedo = Core::LoadTexture(albedoPath.c_str());
-	textureSet.normal = Core::LoadTexture(normalPath.c_str());
-	textureSet.ao = Core::LoadTexture(aoPath.c_str());
-	textureSet.roughness = Core::LoadTexture(roughnessPath.c_str());
-	textureSet.metallic = Core::LoadTexture(metallicPath.c_str());
-	return textureSet;
+int addMaterial(const std::string& albedoPath, const std::string& normalPath, const std::string& aoPath, const std::string& roughnessPath, const std::string& metallicPath,
+	float bloomThreshold = Core::DEFAULT_BLOOM_THRESHOLD) {
+	const std::string paths[Core::MAX_MATERIAL_TEXTURES] = { albedoPath, normalPath, aoPath, roughnessPath, metallicPath };
+	return materialLibrary.Add(paths, bloomThreshold);
 }
 
-void initTextures() {
-	textures.sun.albedo = Core::LoadTexture("./textures/sun/sun_albedo.jpg");
-	textures.sun.normal = Core::LoadTexture("./textures/sun/sun_normal.jpg");
-
-	textures.spaceship.albedo = Core::LoadTexture("./textures/spaceship/spaceship_albedo.jpg");
-	textures.spaceship.normal = Core::LoadTexture("./textures/spaceship/spaceship_normal.jpg");
-	textures.spaceship.ao = Core::LoadTexture("./textures/spaceship/spaceship_ao.jpg");
-	textures.spaceship.roughness = Core::LoadTexture("./textures/spaceship/spaceship_roughness.jpg");
-	textures.spaceship.metallic = Core::LoadTexture("./textures/spaceship/spaceship_metallic.jpg");
-
-	textures.planets.mercury = loadTextureSet("./textures/planets/mercury/planet1_albedo.png", "./textures/planets/mercury/planet1_normal.png", "./textures/planets/mercury/planet1_ao.png", "./textures/planets/mercury/planet1_roughness.png", "./textures/planets/mercury/planet1_metallic.png");
-	textures.planets.venus = loadTextureSet("./textures/planets/venus/planet2_albedo.png", "./textures/planets/venus/planet2_normal.png", "./textures/planets/venus/planet2_ao.png", "./textures/planets/venus/planet2_roughness.png", "./textures/planets/venus/planet2_metallic.png");
-	textures.planets.venus = loadTextureSet("./textures/planets/venus/planet2_albedo.png", "./textures/planets/venus/planet2_normal.png", "./textures/planets/venus/planet2_ao.png", "./textures/planets/venus/planet2_roughness.png", "./textures/planets/venus/planet2_metallic.png");
-	textures.planets.earth = loadTextureSet("./textures/planets/earth/earth_albedo.jpg", "./textures/planets/earth/earth_normal.jpg", "./textures/planets/earth/earth_ao.png", "./textures/planets/earth/earth_roughness.jpg", "./textures/planets/earth/earth_metallic.png");
-	textures.planets.mars = loadTextureSet("./textures/planets/mars/mars_albedo.jpg", "./textures/planets/mars/mars_normal.png", "./textures/planets/mars/mars_ao.jpg", "./textures/planets/mars/mars_roughness.jpg", "./textures/planets/mars/mars_metallic.png");
-	textures.planets.jupiter = loadTextureSet("./textures/planets/jupiter/jupiter_albedo.jpg", "./textures/planets/jupiter/jupiter_normal.png", "./textures/planets/jupiter/jupiter_ao.jpg", "./textures/planets/jupiter/jupiter_roughness.jpg", "./textures/planets/jupiter/jupiter_metallic.png");
-	textures.planets.saturn = loadTextureSet("./textures/planets/saturn/planet3_albedo.png", "./textures/planets/saturn/planet3_normal.png", "./textures/planets/saturn/planet3_ao.png", "./textures/planets/saturn/planet3_roughness.png", "./textures/planets/saturn/planet3_metallic.png");
-	textures.planets.uran = loadTextureSet("./textures/planets/uranus/planet5_albedo.jpg", "./textures/planets/uranus/planet5_normal.png", "./textures/planets/uranus/planet5_ao.jpg", "./textures/planets/uranus/planet5_roughness.jpg", "./textures/planets/uranus/planet5_metallic.png");
-	textures.planets.neptune = loadTextureSet("./textures/planets/neptune/neptune_albedo.jpg", "./textures/planets/neptune/neptune_normal.png", "./textures/planets/neptune/neptune_ao.jpg", "./textures/planets/neptune/neptune_roughness.jpg", "./textures/planets/neptune/neptune_metallic.png");
-	textures.trash1 = loadTextureSet("./textures/trash/trash1_albedo.jpg", "./textures/trash/trash1_normal.png", "./textures/trash/trash1_AO.jpg", "./textures/trash/trash1_roughness.jpg", "./textures/trash/trash1_metallic.jpg");
-	textures.trash2 = loadTextureSet("./textures/trash/trash2_albedo.jpg", "./textures/trash/trash2_normal.png", "./textures/trash/trash2_AO.jpg", "./textures/trash/trash2_roughness.jpg", "./textures/trash/trash2_metallic.jpg");
-	textures.asteroid = loadTextureSet("./textures/asteroid/asteroid_albedo.png", "./textures/asteroid/asteroid_normal.png", "./textures/planets/mars/mars_ao.jpg", "./textures/asteroid/asteroid_roughness.png", "./textures/asteroid/asteroid_metallic.png");
-	textures.barier = loadTextureSet("./textures/barier/barier_albedo.jpeg", "./textures/barier/barier_normal.png", "./textures/planets/barier/barier_ao.png", "./textures/barier/barier_roughness.jpeg", "./textures/barier/barier_metallic.png");
-	textures.laser.albedo = Core::LoadTexture("./textures/spaceship/laser_albedo.jpg");
-	textures.laser.normal = Core::LoadTexture("./textures/spaceship/laser_normal.png");
-	textures.circle_bright = loadTextureSet("./textures/circle/circle_albedo_bright.jpg", "./textures/circle/circle_normal.png", "./textures/circle/circle_ao.jpg", "./textures/circle/circle_roughness.jpg", "./textures/circle/circle_metallic.jpg");
-	textures.circle_dark = loadTextureSet("./textures/circle/circle_albedo_dark.jpg", "./textures/circle/circle_normal.png", "./textures/circle/circle_ao.jpg", "./textures/circle/circle_roughness.jpg", "./textures/circle/circle_metallic.jpg");
-
-	sprites.sprite_1 = Core::LoadTexture("./img/mission_board_1.png");
-	sprites.sprite_2 = Core::LoadTexture("./img/mission_board_2.png");
-	sprites.sprite_3 = Core::LoadTexture("./img/mission_board_3.png");
-	sprites.sprite_4 = Core::LoadTexture("./img/mission_board_4.png");
-	sprites.sprite_end = Core::LoadTexture("./img/mission_board_end.png");
-	sprites.sprite_start = Core::LoadTexture("./img/instruction.png");
-
-	std::string skyboxFilepaths[6] = {
+// The six sprites in the order of spriteTextures in initTextures, then the skybox faces.
+const char* const IMAGE_PATHS[] = {
+	"./img/mission_board_1.png",
+	"./img/mission_board_2.png",
+	"./img/mission_board_3.png",
+	"./img/mission_board_4.png",
+	"./img/mission_board_end.png",
+	"./img/instruction.png",
 	"./textures/skybox/skybox_right.png",
 	"./textures/skybox/skybox_left.png",
 	"./textures/skybox/skybox_top.png",
 	"./textures/skybox/skybox_bot.png",
 	"./textures/skybox/skybox_front.png",
 	"./textures/skybox/skybox_back.png"
-	};
-	skyboxTexture = Core::LoadSkybox(skyboxFilepaths);
-}
+};
+const int IMAGE_COUNT = sizeof(IMAGE_PATHS) / sizeof(IMAGE_PATHS[0]);
 
-void initBloom() {
-	glGenFramebuffers(1, &hdrFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	glGenTextures(2, colorBuffers);
-	for (unsigned int i = 0; i < 2; i++)
-	{
-		glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1920, 1080, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-	}
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, 1920, 1080);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-
-	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, attachments);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glGenFramebuffers(2, pingpongFBO);
-	glGenTextures(2, pingpongColorbuffers);
-	for (unsigned int i = 0; i < 2; i++)
+void initTextures() {
+	materials.sun = addMaterial("./textures/sun/sun_albedo.jpg", "./textures/sun/sun_normal.jpg", "", "", "", EMISSIVE_BLOOM_THRESHOLD);
+	materials.spaceship = addMaterial("./textures/spaceship/spaceship_albedo.jpg", "./textures/spaceship/spaceship_normal.jpg", "./textures/spaceship/spaceship_ao.jpg", "./textures/spaceship/spaceship_roughness.jpg", "./textures/spaceship/spaceship_metallic.jpg");
+
+	materials.planets.mercury = addMaterial("./textures/planets/mercury/planet1_albedo.png", "./textures/planets/mercury/planet1_normal.png", "./textures/planets/mercury/planet1_ao.png", "./textures/planets/mercury/planet1_roughness.png", "./textures/planets/mercury/planet1_metallic.png");
+	materials.planets.venus = addMaterial("./textures/planets/venus/planet2_albedo.png", "./textures/planets/venus/planet2_normal.png", "./textures/planets/venus/planet2_ao.png", "./textures/planets/venus/planet2_roughness.png", "./textures/planets/venus/planet2_metallic.png");
+	materials.planets.venus = addMaterial("./textures/planets/venus/planet2_albedo.png", "./textures/planets/venus/planet2_normal.png", "./textures/planets/venus/planet2_ao.png", "./textures/planets/venus/planet2_roughness.png", "./textures/planets/venus/planet2_metallic.png");
+	materials.planets.earth = addMaterial("./textures/planets/earth/earth_albedo.jpg", "./textures/planets/earth/earth_normal.jpg", "./textures/planets/earth/earth_ao.png", "./textures/planets/earth/earth_roughness.jpg", "./textures/planets/earth/earth_metallic.png");
+	materials.planets.mars = addMaterial("./textures/planets/mars/mars_albedo.jpg", "./textures/planets/mars/mars_normal.png", "./textures/planets/mars/mars_ao.jpg", "./textures/planets/mars/mars_roughness.jpg", "./textures/planets/mars/mars_metallic.png");
+	materials.planets.jupiter = addMaterial("./textures/planets/jupiter/jupiter_albedo.jpg", "./textures/planets/jupiter/jupiter_normal.png", "./textures/planets/jupiter/jupiter_ao.jpg", "./textures/planets/jupiter/jupiter_roughness.jpg", "./textures/planets/jupiter/jupiter_metallic.png");
+	materials.planets.saturn = addMaterial("./textures/planets/saturn/planet3_albedo.png", "./textures/planets/saturn/planet3_normal.png", "./textures/planets/saturn/planet3_ao.png", "./textures/planets/saturn/planet3_roughness.png", "./textures/planets/saturn/planet3_metallic.png");
+	materials.planets.uran = addMaterial("./textures/planets/uranus/planet5_albedo.jpg", "./textures/planets/uranus/planet5_normal.png", "./textures/planets/uranus/planet5_ao.jpg", "./textures/planets/uranus/planet5_roughness.jpg", "./textures/planets/uranus/planet5_metallic.png");
+	materials.planets.neptune = addMaterial("./textures/planets/neptune/neptune_albedo.jpg", "./textures/planets/neptune/neptune_normal.png", "./textures/planets/neptune/neptune_ao.jpg", "./textures/planets/neptune/neptune_roughness.jpg", "./textures/planets/neptune/neptune_metallic.png");
+	materials.trash1 = addMaterial("./textures/trash/trash1_albedo.jpg", "./textures/trash/trash1_normal.png", "./textures/trash/trash1_AO.jpg", "./textures/trash/trash1_roughness.jpg", "./textures/trash/trash1_metallic.jpg");
+	materials.trash2 = addMaterial("./textures/trash/trash2_albedo.jpg", "./textures/trash/trash2_normal.png", "./textures/trash/trash2_AO.jpg", "./textures/trash/trash2_roughness.jpg", "./textures/trash/trash2_metallic.jpg");
+	materials.asteroid = addMaterial("./textures/asteroid/asteroid_albedo.png", "./textures/asteroid/asteroid_normal.png", "./textures/planets/mars/mars_ao.jpg", "./textures/asteroid/asteroid_roughness.png", "./textures/asteroid/asteroid_metallic.png");
+	materials.barier = addMaterial("./textures/barier/barier_albedo.jpeg", "./textures/barier/barier_normal.png", "./textures/planets/barier/barier_ao.png", "./textures/barier/barier_roughness.jpeg", "./textures/barier/barier_metallic.png");
+	materials.laser = addMaterial("./textures/spaceship/laser_albedo.jpg", "./textures/spaceship/laser_normal.png", "", "", "", EMISSIVE_BLOOM_THRESHOLD);
+	materials.circle_bright = addMaterial("./textures/circle/circle_albedo_bright.jpg", "./textures/circle/circle_normal.png", "./textures/circle/circle_ao.jpg", "./textures/circle/circle_roughness.jpg", "./textures/circle/circle_metallic.jpg");
+	materials.circle_dark = addMaterial("./textures/circle/circle_albedo_dark.jpg", "./textures/circle/circle_normal.png", "./textures/circle/circle_ao.jpg", "./textures/circle/circle_roughness.jpg", "./textures/circle/circle_metallic.jpg");
+
+	// the sprites and skybox faces decode alongside the material maps
+	Core::ImageData images[IMAGE_COUNT];
+	Core::JobCounter imagesDecoded;
+	for (int i = 0; i < IMAGE_COUNT; i++)
+		jobSystem.Run([&images, i]() { images[i] = Core::DecodeImage(IMAGE_PATHS[i]); }, &imagesDecoded);
+
+	materialLibrary.Build(jobSystem);
+	jobSystem.Wait(imagesDecoded);
+
+	for (int i = 0; i < IMAGE_COUNT; i++)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-		glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1920, 1080, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-			std::cout << "Framebuffer not complete!" << std::endl;
+		if (!images[i].pixels)
+			std::cerr << "Error loading image: " << IMAGE_PATHS[i] << std::endl;
 	}
-	glUseProgram(programBlur);
-	glUniform1i(glGetUniformLocation(programBlur, "image"), 0);
+	GLuint* spriteTextures[6] = { &sprites.sprite_1, &sprites.sprite_2, &sprites.sprite_3, &sprites.sprite_4, &sprites.sprite_end, &sprites.sprite_start };
+	for (int i = 0; i < 6; i++)
+		*spriteTextures[i] = Core::CreateTexture(images[i]);
+	skyboxTexture = Core::CreateSkybox(images + 6);
+	for (Core::ImageData& image : images)
+		Core::FreeImage(image);
+}
+
+void initDrawProgram(Core::DrawProgram& drawProgram, GLuint program) {
+	drawProgram.id = program;
+	drawProgram.modelMatrix = shaderLoader.GetUniform(program, "modelMatrix");
+	drawProgram.materialIndex = shaderLoader.GetUniform(program, "materialIndex");
+	drawProgram.materialMaps = shaderLoader.GetSampler(program, "materialMaps");
+}
+
+void initUniforms() {
+	initDrawProgram(uniforms.programDefaultInstanced, programDefaultInstanced);
+	uniforms.programDefaultInstanced.multiDraw = true;
+	initDrawProgram(uniforms.programSun, programSun);
+
+	uniforms.programBlur.horizontal = shaderLoader.GetUniform(programBlur, "horizontal");
+	uniforms.programBlur.image = shaderLoader.GetSampler(programBlur, "image");
+
+	uniforms.programBrightPass.scene = shaderLoader.GetSampler(programBrightPass, "scene");
+	uniforms.programBrightPass.downscale = shaderLoader.GetUniform(programBrightPass, "downscale");
+	uniforms.programBrightPass.threshold = shaderLoader.GetUniform(programBrightPass, "threshold");
+
+	uniforms.programBloomFinal.bloom = shaderLoader.GetUniform(programBloomFinal, "bloom");
+	uniforms.programBloomFinal.exposure = shaderLoader.GetUniform(programBloomFinal, "exposure");
+	uniforms.programBloomFinal.upscale = shaderLoader.GetUniform(programBloomFinal, "upscale");
+	uniforms.programBloomFinal.scene = shaderLoader.GetSampler(programBloomFinal, "scene");
+	uniforms.programBloomFinal.bloomBlur = shaderLoader.GetSampler(programBloomFinal, "bloomBlur");
+
+	// the sun direction never changes, so it is set once instead of on every sun and laser draw
+	Core::UseProgram(programSun);
+	glUniform3f(shaderLoader.GetUniform(programSun, "lightDir").location, sunDirection.x, sunDirection.y, sunDirection.z);
+	Core::UseProgram(programSkybox);
+	glUniform1f(shaderLoader.GetUniform(programSkybox, "bloomThreshold").location, SKYBOX_BLOOM_THRESHOLD);
+	Core::UseProgram(programSprite);
+	glUniform1f(shaderLoader.GetUniform(programSprite, "bloomThreshold").location, SPRITE_BLOOM_THRESHOLD);
+}
 
-	glUseProgram(programBloomFinal);
-	glUniform1i(glGetUniformLocation(programBloomFinal, "scene"), 0);
-	glUniform1i(glGetUniformLocation(programBloomFinal, "bloomBlur"), 1);
+void parseArguments(int argc, char** argv) {
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--targets" && i + 1 < argc)
+		{
+			if (!Core::ParseRenderTargetProfile(argv[++i], renderTargetProfile))
+				std::cout << "unknown target profile " << argv[i] << ", expected quality, balanced or low" << std::endl;
+		}
+		else if (argument == "--gpu-profile" && i + 1 < argc)
+			gpuProfilePath = argv[++i];
+		else if (argument == "--trace" && i + 1 < argc)
+			Core::BeginTraceCapture(argv[++i]);
+		else if (argument == "--record" && i + 1 < argc)
+			inputRecorder.Open(argv[++i]);
+		else if (argument == "--replay" && i + 1 < argc)
+			inputReplay.Open(argv[++i]);
+		else if (argument == "--benchmark")
+			benchmark.enabled = true;
+		else if (argument == "--job-benchmark")
+			jobBenchmark = true;
+		else if (argument == "--transform-benchmark")
+			transformBenchmark = true;
+		else if (argument == "--frames" && i + 1 < argc)
+			benchmark.frames = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--resolution" && i + 1 < argc)
+		{
+			if (!Core::ParseResolution(argv[++i], benchmark.width, benchmark.height))
+				std::cout << "unknown resolution " << argv[i] << ", expected <width>x<height>" << std::endl;
+		}
+		else
+			std::cout << "unknown argument " << argument << std::endl;
+	}
 }
 
 void init(GLFWwindow* window)
 {
+	jobSystem.Init();
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glfwGetCursorPos(window, &lastMouseX, &lastMouseY);
+	if (benchmark.enabled)
+	{
+		// a fixed render size keeps runs comparable, and vsync would hide the frame time
+		dynamicResolution.SetEnabled(false);
+		glfwSwapInterval(0);
+	}
 
-	glEnable(GL_DEPTH_TEST);
+	Core::Enable(GL_DEPTH_TEST);
 
-	programDefault = shaderLoader.CreateProgram("shaders/shader_default.vert", "shaders/shader_default.frag");
+	programDefaultInstanced = shaderLoader.CreateProgram("shaders/shader_default_instanced.vert", "shaders/shader_default.frag");
 	programSun = shaderLoader.CreateProgram("shaders/shader_sun.vert", "shaders/shader_sun.frag");
 	programSprite = shaderLoader.CreateProgram("shaders/shader_sprite.vert", "shaders/shader_sprite.frag");
 	programSkybox = shaderLoader.CreateProgram("shaders/shader_skybox.vert", "shaders/shader_skybox.frag");
 
 	programBlur = shaderLoader.CreateProgram("shaders/shader_blur.vert", "shaders/shader_blur.frag");
+	programBrightPass = shaderLoader.CreateProgram("shaders/shader_blur.vert", "shaders/shader_bright_pass.frag");
+	programBloomDown = shaderLoader.CreateProgram("shaders/shader_blur.vert", "shaders/shader_bloom_down.frag");
+	programBloomUp = shaderLoader.CreateProgram("shaders/shader_blur.vert", "shaders/shader_bloom_up.frag");
 	programBloomFinal = shaderLoader.CreateProgram("shaders/shader_bloom_final.vert", "shaders/shader_bloom_final.frag");
-
-	loadModelToContext("./models/sphere.obj", contexts.sphereContext);
-	loadModelToContext("./models/spaceship.fbx", contexts.shipContext);
-	loadModelToContext("./models/trash1.dae", contexts.trash1Context);
-	loadModelToContext("./models/trash2.dae", contexts.trash2Context);
-	loadModelToContext("./models/asteroid.obj", contexts.asteroidContext);
-	loadModelToContext("./models/laser.glb", contexts.laserContext);
-	loadModelToContext("./models/cube.obj", contexts.skyboxContext);
-	loadModelToContext("./models/barier.fbx", contexts.barierContext);
-	loadModelToContext("./models/circle.dae", contexts.circleContext);
+	initUniforms();
+	frameUniformBuffer.Init();
+
+	loadModelToContext("./models/sphere.obj", contexts.sphereContext, geometryArena);
+	loadModelToContext("./models/spaceship.fbx", contexts.shipContext, geometryArena);
+	loadModelToContext("./models/trash1.dae", contexts.trash1Context, geometryArena);
+	loadModelToContext("./models/trash2.dae", contexts.trash2Context, geometryArena);
+	loadModelToContext("./models/asteroid.obj", contexts.asteroidContext, geometryArena);
+	loadModelToContext("./models/laser.glb", contexts.laserContext, geometryArena);
+	loadModelToContext("./models/cube.obj", contexts.skyboxContext, geometryArena);
+	loadModelToContext("./models/barier.fbx", contexts.barierContext, geometryArena);
+	loadModelToContext("./models/circle.dae", contexts.circleContext, geometryArena);
+	geometryArena.Upload();
+	renderQueue.Init();
 
 	initTextures();
 
@@ -639,85 +1204,236 @@ void init(GLFWwindow* window)
 	renderSpriteEnd = new Core::RenderSprite();
 	renderSpriteStart = new Core::RenderSprite();
 
+	renderSprite->SetProgram(shaderLoader, programSprite);
+	renderSpriteEnd->SetProgram(shaderLoader, programSprite);
+	renderSpriteStart->SetProgram(shaderLoader, programSprite);
 	renderSprite->UpdateSprite(sprites.sprite_1);
 	renderSpriteEnd->UpdateSprite(sprites.sprite_end);
 	renderSpriteStart->UpdateSprite(sprites.sprite_start);
-		
-	initBloom();
+
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	aspectRatio = framebufferWidth / float(framebufferHeight);
+	updateRenderSize();
+	bloomPyramid.Init(shaderLoader, programBloomDown, programBloomUp);
+	reportBloomCost();
+	gpuProfiler.Init();
+	// names the passes in captures and debug output and times them
+	renderGraph.SetPassHooks(
+		[](const char* name) {
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+			gpuProfiler.BeginPass(name);
+		},
+		[](const char*) {
+			gpuProfiler.EndPass();
+			glPopDebugGroup();
+		});
+
+	initEntities();
+	startSimulationThread();
+}
+
+// Everything the recorded input decides; equal at the end of a recording and of its replay.
+uint64_t simulationStateHash() {
+	uint64_t hash = Core::HashBytes(&spaceshipPos, sizeof(spaceshipPos));
+	hash = Core::HashBytes(&spaceshipDir, sizeof(spaceshipDir), hash);
+	hash = Core::HashBytes(&laser.position, sizeof(laser.position), hash);
+	hash = Core::HashBytes(&raceStartTime, sizeof(raceStartTime), hash);
+	int progress[5] = { trashDestroyed, circleVisited, raceCompleted, trashCompleted, laser.isActive };
+	return Core::HashBytes(progress, sizeof(progress), hash);
 }
 
 void shutdown(GLFWwindow* window)
 {
+	// the simulation runs what input is left; the game state is only safe to read after
+	stopSimulationThread();
+	jobSystem.Shutdown();
 	delete renderSprite;
 	delete renderSpriteEnd;
 	delete renderSpriteStart;
-	shaderLoader.DeleteProgram(programDefault);
+	shaderLoader.DeleteProgram(programDefaultInstanced);
+	frameUniformBuffer.Destroy();
+	renderQueue.Destroy();
+	geometryArena.Destroy();
+	materialLibrary.Destroy();
+	renderGraph.Destroy();
+	// frames still in flight finish before the context goes away
+	glFinish();
+	gpuProfiler.Collect();
+	if (gpuProfiler.IsEnabled() && gpuProfiler.WriteCsv(gpuProfilePath))
+		std::cout << "gpu profile written to " << gpuProfilePath << std::endl;
+	gpuProfiler.Destroy();
+	Core::EndTraceCapture();
+
+	uint64_t stateHash = simulationStateHash();
+	if (inputRecorder.IsOpen())
+		inputRecorder.Close(stateHash);
+	if (inputReplay.IsOpen())
+	{
+		if (stateHash == inputReplay.GetFinalStateHash())
+			std::cout << "input replay: final state matches the recording" << std::endl;
+		else
+			std::cout << "input replay: final state " << std::hex << stateHash << " differs from the recorded "
+				<< inputReplay.GetFinalStateHash() << std::dec << " (ended early or diverged)" << std::endl;
+	}
 	glDeleteTextures(1, &skyboxTexture);
 }
 
-void processInput(GLFWwindow* window)
-{
-	float angleSpeed = 0.05f * deltaTime * 10;
-	float moveSpeed = 0.6f * deltaTime * 60;
-
-	glm::vec3 newSpaceshipPos = spaceshipPos;
-
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
-	if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) hideInstruction = true;
-	if (hideInstruction == true) {
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) newSpaceshipPos += spaceshipDir * moveSpeed;
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) newSpaceshipPos -= spaceshipDir * moveSpeed;
-		if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) showMissions = true; else showMissions = false;
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !laser.isActive)
-		{
-			laser.isActive = true;
-			laser.position = spaceshipPos;
-			laser.direction = spaceshipDir;
-			laser.startTime = glfwGetTime();
-		}
+// Fills frameInput for the next frame; returns false when a replay has run out.
+bool gatherFrameInput(GLFWwindow* window) {
+	if (inputReplay.IsOpen())
+	{
+		// Esc still ends a replay early, without touching the replayed input
+		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+			return false;
+		return inputReplay.Next(frameInput);
 	}
 
-	if (checkCollision(newSpaceshipPos, spaceshipRadius) == false) spaceshipPos = newSpaceshipPos;
+	frameInput = Core::FrameInput();
+	frameInput.time = getTime();
+	if (benchmark.enabled)
+		return true;
 
-	cameraPos = spaceshipPos - 1.5 * spaceshipDir + glm::vec3(0, 1, 0) * 0.5f;
-	cameraDir = spaceshipDir;
+	const int keys[][2] = {
+		{ GLFW_KEY_ESCAPE, Core::INPUT_KEY_ESCAPE }, { GLFW_KEY_X, Core::INPUT_KEY_X },
+		{ GLFW_KEY_W, Core::INPUT_KEY_W }, { GLFW_KEY_S, Core::INPUT_KEY_S },
+		{ GLFW_KEY_TAB, Core::INPUT_KEY_TAB }, { GLFW_KEY_B, Core::INPUT_KEY_B },
+		{ GLFW_KEY_P, Core::INPUT_KEY_P }, { GLFW_KEY_SPACE, Core::INPUT_KEY_SPACE }
+	};
+	for (const auto& key : keys)
+	{
+		if (glfwGetKey(window, key[0]) == GLFW_PRESS)
+			frameInput.keys |= key[1];
+	}
 
-	spotlightPos = spaceshipPos + 0.2 * spaceshipDir;
-	spotlightConeDir = spaceshipDir;
-	
 	double mouseX, mouseY;
 	glfwGetCursorPos(window, &mouseX, &mouseY);
-
-	double mouseMoveX = mouseX - lastMouseX;
-	double mouseMoveY = mouseY - lastMouseY;
-	float mouseSensitivity = 0.1f;
-
-	cameraSide += static_cast<float>(mouseMoveX) * mouseSensitivity;
-	cameraUp -= static_cast<float>(mouseMoveY) * mouseSensitivity;
-
-	spaceshipSide += static_cast<float>(mouseMoveX) * mouseSensitivity;
-	spaceshipUp -= static_cast<float>(mouseMoveY) * mouseSensitivity;
-
-	cameraUp = glm::clamp(cameraUp, -89.0f, 89.0f);
-	spaceshipUp = glm::clamp(cameraUp, -89.0f, 89.0f);
-
+	frameInput.mouseDeltaX = static_cast<float>(mouseX - lastMouseX);
+	frameInput.mouseDeltaY = static_cast<float>(mouseY - lastMouseY);
 	lastMouseX = mouseX;
 	lastMouseY = mouseY;
+	if (inputRecorder.IsOpen())
+		inputRecorder.Write(frameInput);
+	return true;
+}
 
-	glm::quat cameraRotation = glm::quat(glm::vec3(glm::radians(cameraUp), glm::radians(-cameraSide), 0.0f));
-	cameraDir = glm::lerp(cameraDir, glm::rotate(cameraRotation, glm::vec3(0.0f, 0.0f, -1.0f)), 0.1f);
-
-	glm::quat spaceshipRotation = glm::quat(glm::vec3(glm::radians(spaceshipUp), glm::radians(-spaceshipSide), 0.0f));
-	spaceshipDir = glm::lerp(spaceshipDir, glm::rotate(spaceshipRotation, glm::vec3(0.0f, 0.0f, -1.0f)), 0.1f);
-
+// The render thread's part of a frame's input: closing the window and the render settings.
+// The game's part goes to the simulation thread with submitFrameInput.
+void processInput(GLFWwindow* window, const SceneSnapshot& scene)
+{
+	PROFILE_FUNCTION();
+	if (frameInput.IsDown(Core::INPUT_KEY_ESCAPE)) glfwSetWindowShouldClose(window, true);
+	if (scene.hideInstruction == true) {
+		bool bloomKey = frameInput.IsDown(Core::INPUT_KEY_B);
+		if (bloomKey && !bloomKeyDown)
+		{
+			bloomMode = bloomMode == BLOOM_PYRAMID ? BLOOM_GAUSSIAN : BLOOM_PYRAMID;
+			renderGraph.RequestReport();
+			reportBloomCost();
+		}
+		bloomKeyDown = bloomKey;
+		bool profileKey = frameInput.IsDown(Core::INPUT_KEY_P);
+		if (profileKey && !profileKeyDown)
+		{
+			renderTargetProfile = (Core::RenderTargetProfile)((renderTargetProfile + 1) % Core::TARGET_PROFILE_COUNT);
+			updateRenderSize();
+			std::cout << "render target profile " << Core::GetRenderTargetFormats(renderTargetProfile).name << std::endl;
+			renderGraph.RequestReport();
+			reportBloomCost();
+		}
+		profileKeyDown = profileKey;
+	}
 }
 
 void renderLoop(GLFWwindow* window) {
 	while (!glfwWindowShouldClose(window))
 	{
-		processInput(window);
+		if (!gatherFrameInput(window))
+			break;
+		int submitted = submitFrameInput();
+		const SceneSnapshot& scene = readSceneSnapshot(submitted);
+		processInput(window, scene);
 
-		renderScene(window);
+		renderScene(window, scene);
 		glfwPollEvents();
+		Core::FlushTraceCapture();
 	}
-}
\ No newline at end of file
+}
+
+void runBenchmark(GLFWwindow* window) {
+	std::cout << "benchmark: " << benchmark.warmupFrames << " warm-up frames, then " << benchmark.frames << " frames" << std::endl;
+	int totalFrames = benchmark.warmupFrames + benchmark.frames;
+	for (int frame = 0; frame < totalFrames && !glfwWindowShouldClose(window); frame++)
+	{
+		benchmarkMeasuring = frame >= benchmark.warmupFrames;
+		simulatedTime = frame * (double)benchmark.frameTime;
+		auto frameStart = std::chrono::steady_clock::now();
+
+		// a replay makes the benchmark a recorded gameplay session instead of the path
+		if (!gatherFrameInput(window))
+			break;
+		int submitted = submitFrameInput();
+		const SceneSnapshot& scene = readSceneSnapshot(submitted);
+		processInput(window, scene);
+		renderScene(window, scene);
+		glfwPollEvents();
+		Core::FlushTraceCapture();
+
+		if (benchmarkMeasuring)
+		{
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - frameStart).count();
+			const Core::RenderQueueStats& stats = renderQueue.GetStats();
+			benchmarkRecorder.AddCpuFrame(seconds, stats.drawCalls, stats.triangles, renderGraph.GetStats().passes);
+		}
+	}
+
+	// the GPU times of the last frames are still in flight
+	glFinish();
+	gpuProfiler.Collect();
+	float gpuFrameTime;
+	while (gpuProfiler.ReadFrameTime(gpuFrameTime))
+		benchmarkRecorder.AddGpuFrame(gpuFrameTime);
+	benchmarkMeasuring = false;
+	benchmarkRecorder.Report(benchmark);
+}
+
+// Scaling of the job system from one thread to all of them on the two parallel paths: decoding
+// every image the game loads, and the per-frame transform and culling work, here done for
+// JOB_BENCHMARK_OBJECTS planets and trash so the split has enough to work on.
+const int JOB_BENCHMARK_OBJECTS = 100000;
+
+void runJobBenchmark() {
+	// culls against the starting camera, as the first frame would
+	updateFrameUniforms();
+	int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	std::vector<std::string> imagePaths;
+	for (const std::string& path : materialLibrary.GetLayerPaths())
+	{
+		if (!path.empty())
+			imagePaths.push_back(path);
+	}
+	imagePaths.insert(imagePaths.end(), IMAGE_PATHS, IMAGE_PATHS + IMAGE_COUNT);
+	Core::MeasureJobScaling("image decoding", maxThreads, 1, [&imagePaths](Core::JobSystem& jobs) {
+		jobs.ParallelFor((int)imagePaths.size(), 1, [&imagePaths](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				Core::ImageData image = Core::DecodeImage(imagePaths[i].c_str());
+				Core::FreeImage(image);
+			}
+		});
+	});
+
+	Core::TransformBatch transforms;
+	transforms.Resize(JOB_BENCHMARK_OBJECTS);
+	std::vector<glm::mat4> matrices(JOB_BENCHMARK_OBJECTS);
+	std::vector<char> visible(JOB_BENCHMARK_OBJECTS);
+	Core::MeasureJobScaling("transforms and culling", maxThreads, 20, [&transforms, &matrices, &visible](Core::JobSystem& jobs) {
+		jobs.ParallelFor(JOB_BENCHMARK_OBJECTS / PLANET_TRANSFORMS, 256, [&transforms, &matrices, &visible](int begin, int end) {
+			for (int i = begin; i < end; i++)
+				setPlanetTransforms(PLANET_ORBITS[i % 8], i * 0.01f, transforms, i * PLANET_TRANSFORMS);
+			Core::ComposeTransforms(transforms, begin * PLANET_TRANSFORMS, end * PLANET_TRANSFORMS, matrices.data());
+			for (int i = begin * PLANET_TRANSFORMS; i < end * PLANET_TRANSFORMS; i++)
+				visible[i] = Core::IsVisible(cameraView.frustum, contexts.sphereContext, matrices[i]);
+		});
+	});
+}